@@ -1,3 +1,6 @@
+#ifndef UTILS_H
+#define UTILS_H
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +14,119 @@ typedef struct {
     double field_fp;
 } Record;
 
+/**
+ * Statistics gathered by sort_probe() on a small sample of the input.
+ * Pairs are counted between neighbours inside the sampled windows, while
+ * distinct keys are counted on a strided sample sorted with merge_sort.
+ */
+typedef struct {
+    size_t sampled;     // neighbouring pairs compared inside the windows
+    size_t ascents;     // pairs with a < b
+    size_t descents;    // pairs with a > b
+    size_t keys;        // elements in the strided sample
+    size_t distinct;    // distinct keys among them
+} SortProbe;
+
+/**
+ * Key of a sparse index entry: an integer, a double, or the offset of a string in the
+ * index string pool, depending on the indexed field.
+ */
+typedef union {
+    int64_t i;
+    double d;
+    uint64_t str;
+} SparseIndexKey;
+
+typedef struct {
+    SparseIndexKey key;
+    uint64_t scan_from;     // offset of the previous sampled line in the sorted file
+} SparseIndexEntry;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t field;
+    uint32_t reserved;
+    uint64_t stride;        // lines between two sampled keys
+    uint64_t count;         // number of entries
+    uint64_t lines;         // lines in the sorted file
+    uint64_t last_offset;   // offset of the last sampled line
+    uint64_t pool_size;     // bytes of string keys following the entries
+} SparseIndexHeader;
+
+/**
+ * Sidecar index of a sorted output file: every stride-th key with the position to scan
+ * from, stored in Eytzinger order for a cache-friendly search.
+ */
+typedef struct {
+    SparseIndexHeader header;
+    SparseIndexEntry *entries;
+    char *pool;
+} SparseIndex;
+
+/**
+ * Chunked reader or writer over the descriptor of a regular file (see io_backend.c).
+ */
+typedef struct IoFile IoFile;
+
+/**
+ * Gzip reader or writer that inflates or deflates on its own thread (see gzip_stream.c).
+ */
+typedef struct GzipStream GzipStream;
+
+/**
+ * Output kept open across several batches of records and verbatim lines (see records.c).
+ */
+typedef struct RecordWriter RecordWriter;
+
+/**
+ * Work counted by the sorting code when built with SORT_STATS (make STATS=1).
+ * Each thread counts in its own copy, added to the totals by stats_flush().
+ */
+typedef struct {
+    uint64_t comparisons;
+    uint64_t bytes_moved;   // bytes copied or moved between elements and buffers
+    uint64_t allocations;
+    uint64_t max_depth;     // deepest recursion of the sorting algorithms
+    uint64_t depth;         // current recursion depth
+} SortCounters;
+
+/**
+ * Wall-clock and process CPU time at the start of a phase (see stats_phase_begin).
+ */
+typedef struct {
+    double wall;
+    double cpu;
+} StatsClock;
+
+enum {
+    STATS_PHASE_COUNT,
+    STATS_PHASE_LOAD,
+    STATS_PHASE_SORT,
+    STATS_PHASE_SAVE,
+    STATS_PHASES
+};
+
+#ifdef SORT_STATS
+extern __thread SortCounters stats_local;
+
+#define STATS_COMPARE() (stats_local.comparisons++)
+#define STATS_MOVE(bytes) (stats_local.bytes_moved += (bytes))
+#define STATS_ALLOC() (stats_local.allocations++)
+#define STATS_ENTER()                                      \
+    do {                                                   \
+        if (++stats_local.depth > stats_local.max_depth)   \
+            stats_local.max_depth = stats_local.depth;     \
+    } while (0)
+#define STATS_LEAVE() (stats_local.depth--)
+#else
+#define STATS_COMPARE() ((void)0)
+#define STATS_MOVE(bytes) ((void)0)
+#define STATS_ALLOC() ((void)0)
+#define STATS_ENTER() ((void)0)
+#define STATS_LEAVE() ((void)0)
+#endif
+
 #define ARGUMENTS_ERROR(a, b)                                                \
     do {                                                                     \
         if ((a) == NULL || (b) == NULL) {                                    \
@@ -19,6 +135,9 @@ typedef struct {
         }                                                                    \
     } while (0)
 
+// room for a formatted line besides the string field: two ints, the longest %f, separators
+#define FORMAT_LINE_SLACK 352
+
 #define GENERIC_ERROR(message)                                        \
     do {                                                              \
         fprintf(stderr, "%s:%d: %s.\n", __FILE__, __LINE__, message); \
@@ -26,4 +145,70 @@ typedef struct {
     } while(0)
 
 extern void merge_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*));
-extern void quick_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*));
\ No newline at end of file
+extern void quick_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*));
+extern void multiway_merge_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*));
+extern void inplace_merge_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*));
+extern void inplace_merge_sort_buffer(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*), void *buffer, size_t buffer_items);
+extern void sort_probe(const void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*), SortProbe *probe);
+
+extern void io_backend_set_direct(int enable);
+extern IoFile *io_reader_open(FILE *file);
+extern char *io_reader_next(IoFile *io, size_t *len);
+extern void io_reader_close(IoFile *io, uint64_t consumed);
+extern IoFile *io_writer_open(FILE *file);
+extern void io_writer_write(IoFile *io, const char *data, size_t len);
+extern uint64_t io_writer_tell(const IoFile *io);
+extern void io_writer_close(IoFile *io);
+
+extern int gzip_detect(FILE *file);
+extern GzipStream *gzip_reader_open(FILE *file);
+extern char *gzip_reader_next(GzipStream *gz, size_t *len);
+extern void gzip_reader_close(GzipStream *gz);
+extern GzipStream *gzip_writer_open(FILE *file);
+extern void gzip_writer_write(GzipStream *gz, const char *data, size_t len);
+extern void gzip_writer_close(GzipStream *gz);
+
+#ifdef SORT_STATS
+extern int (*stats_count_comparisons(int (*compar)(const void *, const void *)))(const void *, const void *);
+#endif
+extern void stats_enable(void);
+extern StatsClock stats_phase_begin(void);
+extern void stats_phase_end(size_t phase, StatsClock start);
+extern void stats_flush(void);
+extern void stats_print_json(FILE *out);
+
+extern int (*record_comparator(size_t field))(const void *, const void *);
+extern void parse_record(char *line, Record *record);
+extern size_t count_lines(FILE *infile);
+extern Record *load_records(FILE *infile, size_t lines);
+extern Record *read_records(FILE *infile, size_t *lines);
+extern void save_records(FILE *outfile, Record *saved_records, size_t lines);
+extern void save_records_gzip(FILE *outfile, Record *saved_records, size_t lines);
+extern void save_records_sampled(FILE *outfile, Record *saved_records, size_t lines, size_t stride, uint64_t *offsets);
+extern void save_records_threads(FILE *outfile, Record *saved_records, size_t lines, size_t threads);
+extern char *format_record(char *out, const Record *record);
+extern RecordWriter *record_writer_open(FILE *outfile);
+extern void record_writer_save(RecordWriter *writer, const Record *records, size_t lines);
+extern void record_writer_copy(RecordWriter *writer, const char *data, size_t len);
+extern void record_writer_close(RecordWriter *writer);
+extern void sort_with_algorithm(void *base, size_t lines, size_t size, size_t field, int (*compar)(const void *, const void *), size_t algo);
+extern size_t resolve_algorithm(Record *records, size_t lines, size_t field, size_t algo);
+extern void sort_record_array(Record *records, size_t lines, size_t field, size_t algo);
+
+extern void sort_records_projected(FILE *infile, FILE *outfile, size_t field, size_t algo);
+extern void sort_records_compressed(FILE *infile, FILE *outfile, size_t field, size_t algo);
+extern void sort_records_indexed(FILE *infile, FILE *outfile, size_t field, size_t algo, size_t stride, const char *index_path);
+extern void merge_records_into(FILE *sorted, FILE *delta, FILE *outfile, size_t field, size_t algo);
+extern void sort_records_batch(FILE *infile, const size_t *fields, FILE **outfiles, size_t count, size_t algo);
+extern void pipeline_sort(FILE *infile, FILE *outfile, size_t field, size_t algo);
+extern void distributed_sort(const char *path, FILE *outfile, size_t field, size_t algo, size_t workers);
+
+extern SparseIndex *sparse_index_build(const Record *records, size_t lines, size_t field, size_t stride, const uint64_t *offsets);
+extern void sparse_index_write(const SparseIndex *index, const char *path);
+extern SparseIndex *sparse_index_read(const char *path);
+extern void sparse_index_free(SparseIndex *index);
+extern uint64_t sparse_index_seek(const SparseIndex *index, const SparseIndexKey *key);
+extern SparseIndexKey sparse_index_parse_key(SparseIndex *index, const char *text);
+extern int sparse_index_compare_line(const SparseIndex *index, const char *line, const SparseIndexKey *key);
+
+#endif
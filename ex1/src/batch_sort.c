@@ -0,0 +1,107 @@
+#include "../include/utils.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * Work shared by the batch threads: one sorted output per requested field,
+ * all built from the same loaded records.
+ */
+typedef struct {
+    Record *records;
+    size_t lines;
+    size_t algo;
+    const size_t *fields;
+    FILE **outfiles;
+    size_t count;
+    size_t next;
+    size_t save_threads;    // formatting threads of each job: the cores split between jobs
+    pthread_mutex_t lock;
+} BatchJobs;
+
+/**
+ * @brief Body of a batch thread: takes the next requested field until none is left.
+ * 
+ * Each output sorts its own copy of the Record array; the copies share the field_str
+ * strings of the loaded records, so no string is duplicated. Saving uses the job's
+ * share of the cores, so that the batch as a whole runs about one thread per core.
+ */
+static void *batch_worker(void *arg) {
+    BatchJobs *jobs = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&jobs->lock);
+        size_t job = jobs->next++;
+        pthread_mutex_unlock(&jobs->lock);
+
+        if (job >= jobs->count)
+            return NULL;
+
+        Record *sorted = malloc(jobs->lines * sizeof(Record));
+        if (!sorted)
+            GENERIC_ERROR("malloc: memory allocation failed");
+
+        memcpy(sorted, jobs->records, jobs->lines * sizeof(Record));
+        sort_record_array(sorted, jobs->lines, jobs->fields[job], jobs->algo);
+        save_records_threads(jobs->outfiles[job], sorted, jobs->lines, jobs->save_threads);
+
+        free(sorted);
+    }
+}
+
+/**
+ * @brief Sorts the records of one input file by several fields, loading them only once.
+ * 
+ * The records are loaded and parsed a single time; then every requested field sorts
+ * a copy of the Record array, which is written to its own output file. The copies
+ * share the field_str strings, so only the fixed-size records are duplicated.
+ * Fields are sorted in parallel, on up to one thread per online core.
+ * 
+ * @param infile Pointer to the input file containing records to be sorted.
+ * @param fields The field numbers to sort by (1: string, 2: integer, 3: float).
+ * @param outfiles The output files, one for each entry of fields.
+ * @param count The number of requested outputs.
+ * @param algo The sorting algorithm to use (see sort_records).
+ */
+void sort_records_batch(FILE *infile, const size_t *fields, FILE **outfiles, size_t count, size_t algo) {
+    if (!infile || !fields || !outfiles)
+        GENERIC_ERROR("sort_records_batch: file not provided");
+
+    for (size_t i = 0; i < count; i++)
+        record_comparator(fields[i]);
+
+    size_t lines;
+    Record *records = read_records(infile, &lines);
+
+    BatchJobs jobs = {
+        .records = records,
+        .lines = lines,
+        .algo = algo,
+        .fields = fields,
+        .outfiles = outfiles,
+        .count = count,
+        .next = 0
+    };
+    pthread_mutex_init(&jobs.lock, NULL);
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t nthreads = cores > 0 && (size_t)cores < count ? (size_t)cores : count;
+    jobs.save_threads = cores > 0 && nthreads > 0 && (size_t)cores > nthreads ? (size_t)cores / nthreads : 1;
+
+    pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+    if (!threads)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t t = 0; t < nthreads; t++) {
+        if (pthread_create(&threads[t], NULL, batch_worker, &jobs) != 0)
+            GENERIC_ERROR("pthread_create: error starting a batch thread");
+    }
+    for (size_t t = 0; t < nthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    pthread_mutex_destroy(&jobs.lock);
+    free(threads);
+
+    for (size_t i = 0; i < lines; i++)
+        free(records[i].field_str);
+    free(records);
+}
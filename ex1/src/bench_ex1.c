@@ -0,0 +1,468 @@
+#include "../include/utils.h"
+#include <getopt.h>
+#include <time.h>
+
+// distinct words drawn by the divina distribution, about the vocabulary of the Commedia
+#define BENCH_VOCABULARY 12800
+// distinct keys of the few-unique distribution
+#define BENCH_FEW_UNIQUE 16
+// largest input given to an algorithm known to go quadratic on it (see bench_quadratic)
+#define BENCH_QUADRATIC_LIMIT 10000
+
+typedef enum { TYPE_INT, TYPE_DOUBLE, TYPE_STRING, TYPE_RECORD, TYPES } ElementType;
+typedef enum { DIST_RANDOM, DIST_SORTED, DIST_REVERSE, DIST_ORGAN_PIPE, DIST_FEW_UNIQUE, DIST_DIVINA, DISTS } Distribution;
+
+static const char *type_names[TYPES] = { "int", "double", "string", "record" };
+static const char *dist_names[DISTS] = { "random", "sorted", "reverse", "organ_pipe", "few_unique", "divina" };
+
+typedef struct {
+    const char *name;
+    void (*sort)(void *base, size_t nitems, size_t size, int (*compar)(const void *, const void *));
+    int quadratic;      // degrades to O(n^2) on presorted or low-cardinality inputs
+} BenchAlgorithm;
+
+static const BenchAlgorithm algorithms[] = {
+    { "merge_sort", merge_sort, 0 },
+    { "quick_sort", quick_sort, 1 },
+    { "multiway_merge_sort", multiway_merge_sort, 0 },
+    { "inplace_merge_sort", inplace_merge_sort, 0 },
+    { "libc_qsort", qsort, 0 },
+};
+#define BENCH_ALGORITHMS (sizeof(algorithms) / sizeof(algorithms[0]))
+
+/**
+ * One generated input: the elements to sort and the string pool they point into.
+ */
+typedef struct {
+    void *data;
+    size_t nitems;
+    size_t size;
+    int (*compar)(const void *, const void *);
+    char *pool;
+} Dataset;
+
+static uint64_t rng_state;
+
+// splitmix64: fast, and the same seed always gives the same datasets
+static uint64_t next_random(void) {
+    uint64_t z = (rng_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+static int compare_int(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+
+    return (x > y) - (x < y);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static int compare_string(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * @brief Writes the word of the given vocabulary rank, made of Italian-like syllables.
+ *
+ * Frequent (low rank) words are short, like "e", "che" or "la" in the Commedia.
+ */
+static size_t divina_word(char *out, uint64_t rank) {
+    static const char *syllables[] = {
+        "e", "che", "la", "a", "di", "non", "per", "il", "io", "si", "mi", "in", "ch'", "con",
+        "lo", "ne", "ma", "al", "de", "su", "to", "ra", "co", "an", "vi", "so", "te", "ta",
+        "ri", "do", "ce", "me", "sta", "tra", "gno", "qua", "spi", "glio", "ven", "dan"
+    };
+    const uint64_t base = sizeof(syllables) / sizeof(syllables[0]);
+    size_t len = 0;
+
+    do {
+        const char *syllable = syllables[rank % base];
+        size_t n = strlen(syllable);
+
+        memcpy(out + len, syllable, n);
+        len += n;
+        rank /= base;
+    } while (rank > 0);
+
+    out[len] = '\0';
+    return len;
+}
+
+// writes 6 to 15 random lowercase letters
+static size_t random_word(char *out, uint64_t draw) {
+    size_t len = 6 + draw % 10;
+
+    for (size_t i = 0; i < len; i++) {
+        draw = draw * 6364136223846793005ULL + 1442695040888963407ULL;
+        out[i] = 'a' + (char)((draw >> 33) % 26);
+    }
+
+    out[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief Draws vocabulary ranks following Zipf's law (s = 1), the word frequency
+ * distribution of natural-language texts such as the Divina Commedia.
+ */
+static void zipf_ranks(uint64_t *draws, size_t nitems) {
+    double *cdf = malloc(BENCH_VOCABULARY * sizeof(double));
+    if (!cdf)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    double total = 0.0;
+    for (size_t r = 0; r < BENCH_VOCABULARY; r++) {
+        total += 1.0 / (r + 1);
+        cdf[r] = total;
+    }
+
+    for (size_t i = 0; i < nitems; i++) {
+        double u = (next_random() >> 11) * 0x1.0p-53 * total;
+        size_t lo = 0, hi = BENCH_VOCABULARY - 1;
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (cdf[mid] < u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        draws[i] = lo;
+    }
+
+    free(cdf);
+}
+
+/**
+ * @brief Turns the draws into elements of the given type.
+ *
+ * Random draws become uniformly spread keys (random letters for strings); ranks of the
+ * few-unique and divina distributions become small integers, or their vocabulary word.
+ */
+static void materialize(Dataset *set, ElementType type, const uint64_t *draws, int ranked) {
+    size_t n = set->nitems;
+
+    if (type == TYPE_STRING || type == TYPE_RECORD) {
+        // longest divina word: ceil(log40(BENCH_VOCABULARY)) = 3 syllables of at most 4 bytes
+        set->pool = malloc(n * 16 + 1);
+        if (!set->pool)
+            GENERIC_ERROR("malloc: memory allocation failed");
+    }
+
+    char *next = set->pool;
+    for (size_t i = 0; i < n; i++) {
+        char *word = next;
+
+        if (type == TYPE_STRING || type == TYPE_RECORD)
+            next += (ranked ? divina_word(word, draws[i]) : random_word(word, draws[i])) + 1;
+
+        switch (type) {
+            case TYPE_INT:
+                ((int *)set->data)[i] = ranked ? (int)draws[i] : (int)(uint32_t)draws[i];
+                break;
+            case TYPE_DOUBLE:
+                ((double *)set->data)[i] = ranked ? (double)draws[i] : (draws[i] >> 11) * 0x1.0p-53 * 1e6;
+                break;
+            case TYPE_STRING:
+                ((char **)set->data)[i] = word;
+                break;
+            default: {
+                Record *record = &((Record *)set->data)[i];
+
+                record->id = (int)i;
+                record->field_str = word;
+                record->field_int = (int)(uint32_t)draws[i];
+                record->field_fp = (draws[i] >> 11) * 0x1.0p-53;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Generates nitems elements of a type with the given distribution.
+ *
+ * Sorted, reverse and organ-pipe inputs are random inputs put in shape with the C
+ * library qsort; organ-pipe rises up to the middle of the array and falls after it.
+ * Records are compared by their string field, like bin/main_ex1 with field 1.
+ */
+static Dataset generate(ElementType type, Distribution dist, size_t nitems) {
+    static const size_t sizes[TYPES] = { sizeof(int), sizeof(double), sizeof(char *), sizeof(Record) };
+    Dataset set = { .nitems = nitems, .size = sizes[type] };
+
+    switch (type) {
+        case TYPE_INT:
+            set.compar = compare_int;
+            break;
+        case TYPE_DOUBLE:
+            set.compar = compare_double;
+            break;
+        case TYPE_STRING:
+            set.compar = compare_string;
+            break;
+        default:
+            set.compar = record_comparator(1);
+    }
+
+    uint64_t *draws = malloc((nitems ? nitems : 1) * sizeof(uint64_t));
+    set.data = malloc((nitems ? nitems : 1) * set.size);
+    if (!draws || !set.data)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    if (dist == DIST_DIVINA) {
+        zipf_ranks(draws, nitems);
+    } else {
+        for (size_t i = 0; i < nitems; i++)
+            draws[i] = dist == DIST_FEW_UNIQUE ? next_random() % BENCH_FEW_UNIQUE : next_random();
+    }
+
+    materialize(&set, type, draws, dist == DIST_FEW_UNIQUE || dist == DIST_DIVINA);
+    free(draws);
+
+    if (dist == DIST_SORTED || dist == DIST_REVERSE || dist == DIST_ORGAN_PIPE)
+        qsort(set.data, nitems, set.size, set.compar);
+
+    int8_t *array = set.data;
+    int8_t temp[sizeof(Record)];
+    if (dist == DIST_REVERSE) {
+        for (size_t i = 0, j = nitems; i + 1 < j; i++, j--) {
+            memcpy(temp, array + i * set.size, set.size);
+            memcpy(array + i * set.size, array + (j - 1) * set.size, set.size);
+            memcpy(array + (j - 1) * set.size, temp, set.size);
+        }
+    } else if (dist == DIST_ORGAN_PIPE) {
+        // even ranks rise on the left half, odd ranks fall on the right half
+        int8_t *shaped = malloc((nitems ? nitems : 1) * set.size);
+        if (!shaped)
+            GENERIC_ERROR("malloc: memory allocation failed");
+
+        for (size_t i = 0; i < nitems; i++) {
+            size_t to = i % 2 == 0 ? i / 2 : nitems - 1 - i / 2;
+            memcpy(shaped + to * set.size, array + i * set.size, set.size);
+        }
+        free(set.data);
+        set.data = shaped;
+    }
+
+    return set;
+}
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static int compare_seconds(const void *a, const void *b) {
+    return compare_double(a, b);
+}
+
+static void check_sorted(const Dataset *set, const void *sorted, const char *algorithm) {
+    for (size_t i = 1; i < set->nitems; i++) {
+        if (set->compar((const int8_t *)sorted + (i - 1) * set->size, (const int8_t *)sorted + i * set->size) > 0) {
+            fprintf(stderr, "bench_ex1: %s left the array unsorted at index %zu\n", algorithm, i);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * @brief Tells whether an algorithm would go quadratic on a distribution.
+ *
+ * quick_sort pivots on the last element, so presorted inputs and the long runs of equal
+ * keys of few-unique and divina degrade it to O(n^2) time and O(n) recursion depth.
+ */
+static int bench_quadratic(const BenchAlgorithm *algorithm, Distribution dist) {
+    return algorithm->quadratic && dist != DIST_RANDOM;
+}
+
+/**
+ * @brief Times one algorithm on one dataset and appends a CSV row.
+ *
+ * Each run sorts a fresh copy of the dataset; warmup runs are not timed. The median and
+ * the 95th percentile (nearest rank) are taken over the timed runs, and throughput is
+ * elements per second at the median.
+ */
+static void bench_case(FILE *out, const BenchAlgorithm *algorithm, ElementType type, Distribution dist, const Dataset *set, size_t warmup, size_t repeats, size_t quadratic_limit) {
+    if (bench_quadratic(algorithm, dist) && set->nitems > quadratic_limit) {
+        fprintf(out, "%s,%s,%s,%zu,0,,,,skipped_quadratic\n", algorithm->name, type_names[type], dist_names[dist], set->nitems);
+        return ;
+    }
+
+    void *work = malloc((set->nitems ? set->nitems : 1) * set->size);
+    double *seconds = malloc(repeats * sizeof(double));
+    if (!work || !seconds)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t run = 0; run < warmup + repeats; run++) {
+        memcpy(work, set->data, set->nitems * set->size);
+
+        double start = now_seconds();
+        algorithm->sort(work, set->nitems, set->size, set->compar);
+        double elapsed = now_seconds() - start;
+
+        if (run == 0)
+            check_sorted(set, work, algorithm->name);
+        if (run >= warmup)
+            seconds[run - warmup] = elapsed;
+    }
+
+    qsort(seconds, repeats, sizeof(double), compare_seconds);
+    double median = repeats % 2 ? seconds[repeats / 2] : (seconds[repeats / 2 - 1] + seconds[repeats / 2]) / 2;
+    double p95 = seconds[(95 * repeats + 99) / 100 - 1];
+
+    fprintf(out, "%s,%s,%s,%zu,%zu,%.9f,%.9f,%.0f,ok\n", algorithm->name, type_names[type], dist_names[dist],
+            set->nitems, repeats, median, p95, median > 0 ? set->nitems / median : 0.0);
+    fflush(out);
+
+    free(work);
+    free(seconds);
+}
+
+/**
+ * @brief Parses a comma-separated list of names into a selection mask.
+ */
+static void parse_names(char *list, const char **names, size_t count, int *selected) {
+    memset(selected, 0, count * sizeof(int));
+
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        size_t i = 0;
+        while (i < count && strcmp(names[i], name) != 0)
+            i++;
+        if (i == count) {
+            fprintf(stderr, "bench_ex1: unknown name '%s'\n", name);
+            exit(EXIT_FAILURE);
+        }
+        selected[i] = 1;
+    }
+}
+
+static size_t parse_sizes(char *list, size_t *sizes, size_t max) {
+    size_t count = 0;
+
+    for (char *size = strtok(list, ","); size; size = strtok(NULL, ",")) {
+        if (count == max)
+            GENERIC_ERROR("Error: too many sizes");
+        sizes[count] = strtoul(size, NULL, 10);
+        if (sizes[count] == 0)
+            GENERIC_ERROR("Error: sizes must be positive");
+        count++;
+    }
+
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option options[] = {
+        { "sizes", required_argument, NULL, 'n' },
+        { "types", required_argument, NULL, 't' },
+        { "dists", required_argument, NULL, 'd' },
+        { "algos", required_argument, NULL, 'a' },
+        { "warmup", required_argument, NULL, 'w' },
+        { "repeats", required_argument, NULL, 'r' },
+        { "seed", required_argument, NULL, 's' },
+        { "quadratic-limit", required_argument, NULL, 'q' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *usage = "Usage: bin/bench_ex1 [--sizes N,...] [--types int,double,string,record] "
+                        "[--dists random,sorted,reverse,organ_pipe,few_unique,divina] "
+                        "[--algos merge_sort,quick_sort,multiway_merge_sort,inplace_merge_sort,libc_qsort] "
+                        "[--warmup N] [--repeats N] [--seed N] [--quadratic-limit N] [output_csv]";
+    const char *algorithm_names[BENCH_ALGORITHMS];
+    for (size_t a = 0; a < BENCH_ALGORITHMS; a++)
+        algorithm_names[a] = algorithms[a].name;
+
+    size_t sizes[32] = { 1000, 10000, 100000, 1000000 };
+    size_t nsizes = 4;
+    int types[TYPES] = { 1, 1, 1, 1 };
+    int dists[DISTS] = { 1, 1, 1, 1, 1, 1 };
+    int algos[BENCH_ALGORITHMS];
+    for (size_t a = 0; a < BENCH_ALGORITHMS; a++)
+        algos[a] = 1;
+    size_t warmup = 1;
+    size_t repeats = 5;
+    uint64_t seed = 42;
+    size_t quadratic_limit = BENCH_QUADRATIC_LIMIT;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:t:d:a:w:r:s:q:", options, NULL)) != -1) {
+        switch (opt) {
+            case 'n':
+                nsizes = parse_sizes(optarg, sizes, sizeof(sizes) / sizeof(sizes[0]));
+                break;
+            case 't':
+                parse_names(optarg, type_names, TYPES, types);
+                break;
+            case 'd':
+                parse_names(optarg, dist_names, DISTS, dists);
+                break;
+            case 'a':
+                parse_names(optarg, algorithm_names, BENCH_ALGORITHMS, algos);
+                break;
+            case 'w':
+                warmup = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                repeats = strtoul(optarg, NULL, 10);
+                if (repeats == 0)
+                    GENERIC_ERROR("Error: --repeats expects a positive number");
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'q':
+                quadratic_limit = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                GENERIC_ERROR(usage);
+        }
+    }
+
+    if (argc - optind > 1)
+        GENERIC_ERROR(usage);
+
+    FILE *out = stdout;
+    if (argc - optind == 1) {
+        out = fopen(argv[optind], "w");
+        if (!out)
+            GENERIC_ERROR("fopen: error opening output file");
+    }
+
+    fprintf(out, "algorithm,type,distribution,elements,repeats,median_s,p95_s,elements_per_s,status\n");
+
+    for (size_t s = 0; s < nsizes; s++) {
+        for (size_t t = 0; t < TYPES; t++) {
+            for (size_t d = 0; d < DISTS; d++) {
+                if (!types[t] || !dists[d])
+                    continue;
+
+                // every (type, distribution, size) gets the same input whatever else is selected
+                rng_state = seed ^ (sizes[s] * 0x100000001b3ULL + t * DISTS + d);
+                Dataset set = generate((ElementType)t, (Distribution)d, sizes[s]);
+
+                for (size_t a = 0; a < BENCH_ALGORITHMS; a++) {
+                    if (algos[a])
+                        bench_case(out, &algorithms[a], (ElementType)t, (Distribution)d, &set, warmup, repeats, quadratic_limit);
+                }
+
+                free(set.data);
+                free(set.pool);
+            }
+        }
+    }
+
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
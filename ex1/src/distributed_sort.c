@@ -0,0 +1,512 @@
+#include "../include/utils.h"
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// keys each worker contributes to the splitter selection
+#define DISTRIBUTED_SAMPLES 256
+
+/**
+ * Growable byte buffer holding records in the wire format, one CSV line per record.
+ * The double field is written with %.17g so that it survives the round trip exactly.
+ */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} WireBuffer;
+
+/**
+ * Connections of one worker: a socket to the coordinator and one socket per peer,
+ * indexed by rank (the entry of the worker itself is unused).
+ */
+typedef struct {
+    size_t rank;
+    size_t workers;
+    int coordinator;
+    int *peers;
+} Worker;
+
+/**
+ * Progress of the exchange with one peer: the outgoing bucket and the incoming one,
+ * both preceded on the wire by their length as a 64-bit header.
+ */
+typedef struct {
+    uint64_t out_len;
+    size_t sent;
+    uint64_t in_len;
+    size_t received;
+    char *in;
+} Transfer;
+
+static void wire_append(WireBuffer *buffer, const Record *record) {
+    char line[BUFSIZ];
+    int len = snprintf(line, sizeof(line), "%d,%s,%d,%.17g\n",
+                       record->id, record->field_str, record->field_int, record->field_fp);
+    if (len < 0 || (size_t)len >= sizeof(line))
+        GENERIC_ERROR("snprintf: record too long");
+
+    if (buffer->len + len + 1 > buffer->cap) {
+        buffer->cap = (buffer->len + len + 1) * 2;
+        buffer->data = realloc(buffer->data, buffer->cap);
+        if (!buffer->data)
+            GENERIC_ERROR("realloc: memory allocation failed");
+    }
+
+    memcpy(buffer->data + buffer->len, line, len + 1);
+    buffer->len += len;
+}
+
+/**
+ * @brief Parses the records of a NUL-terminated wire buffer and appends them to an array.
+ *
+ * @param text The lines to parse; they are tokenized in place.
+ * @param records Pointer to the array to append to, grown as needed.
+ * @param count Pointer to the number of records in the array.
+ * @param cap Pointer to the capacity of the array.
+ */
+static void wire_parse(char *text, Record **records, size_t *count, size_t *cap) {
+    char *save = NULL;
+
+    for (char *line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        if (*count == *cap) {
+            *cap = *cap ? *cap * 2 : 1024;
+            *records = realloc(*records, *cap * sizeof(Record));
+            if (!*records)
+                GENERIC_ERROR("realloc: memory allocation failed");
+        }
+
+        parse_record(line, &(*records)[(*count)++]);
+    }
+}
+
+static void write_all(int fd, const void *data, size_t len) {
+    const char *p = data;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0)
+            GENERIC_ERROR("write: error sending data");
+
+        p += n;
+        len -= n;
+    }
+}
+
+static void read_all(int fd, void *data, size_t len) {
+    char *p = data;
+
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0)
+            GENERIC_ERROR("read: connection closed while receiving data");
+
+        p += n;
+        len -= n;
+    }
+}
+
+static void send_message(int fd, const char *data, size_t len) {
+    uint64_t header = len;
+
+    write_all(fd, &header, sizeof(header));
+    write_all(fd, data, len);
+}
+
+static char *recv_message(int fd) {
+    uint64_t header;
+    read_all(fd, &header, sizeof(header));
+
+    char *data = malloc(header + 1);
+    if (!data)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    read_all(fd, data, header);
+    data[header] = '\0';
+
+    return data;
+}
+
+/**
+ * @brief Loads the shard of the input file assigned to a worker.
+ *
+ * The file is split into equal byte ranges; a worker owns every line that starts inside
+ * its range, so a line crossing a boundary belongs to the range where it begins.
+ *
+ * @param path The path of the input CSV file.
+ * @param rank The rank of the worker.
+ * @param workers The number of workers.
+ * @param count Pointer receiving the number of loaded records.
+ * @return Pointer to the array of loaded records.
+ */
+static Record *load_shard(const char *path, size_t rank, size_t workers, size_t *count) {
+    FILE *infile = fopen(path, "r");
+    if (!infile)
+        GENERIC_ERROR("fopen: error opening input file");
+
+    struct stat st;
+    if (fstat(fileno(infile), &st) != 0)
+        GENERIC_ERROR("fstat: error reading input file size");
+
+    off_t start = st.st_size * rank / workers;
+    off_t end = st.st_size * (rank + 1) / workers;
+    char buffer[BUFSIZ];
+
+    if (start > 0) {
+        if (fseeko(infile, start - 1, SEEK_SET) != 0)
+            GENERIC_ERROR("fseeko: error seeking input file");
+
+        // skip the tail of a line that started in the previous shard
+        while (fgets(buffer, sizeof(buffer), infile) && !strchr(buffer, '\n'))
+            ;
+    }
+
+    Record *records = NULL;
+    size_t cap = 0;
+    *count = 0;
+
+    while (ftello(infile) < end && fgets(buffer, sizeof(buffer), infile)) {
+        if (*count == cap) {
+            cap = cap ? cap * 2 : 1024;
+            records = realloc(records, cap * sizeof(Record));
+            if (!records)
+                GENERIC_ERROR("realloc: memory allocation failed");
+        }
+
+        parse_record(buffer, &records[(*count)++]);
+    }
+
+    fclose(infile);
+
+    return records;
+}
+
+/**
+ * @brief Sends every bucket to the worker owning its key range and receives the others.
+ *
+ * All the peer sockets are driven at once with poll() and non-blocking calls, so two
+ * workers sending large buckets to each other never wait on a full socket buffer.
+ *
+ * @param worker Pointer to the connections of the worker.
+ * @param buckets The outgoing buckets, indexed by destination rank.
+ * @return The received buckets, indexed by source rank (NULL for the worker itself).
+ */
+static char **exchange_buckets(Worker *worker, WireBuffer *buckets) {
+    size_t workers = worker->workers;
+    Transfer *transfers = calloc(workers, sizeof(Transfer));
+    struct pollfd *fds = malloc(workers * sizeof(struct pollfd));
+    size_t *ranks = malloc(workers * sizeof(size_t));
+    if (!transfers || !fds || !ranks)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t p = 0; p < workers; p++)
+        transfers[p].out_len = buckets[p].len;
+
+    for (;;) {
+        size_t nfds = 0;
+
+        for (size_t p = 0; p < workers; p++) {
+            Transfer *t = &transfers[p];
+            if (p == worker->rank)
+                continue;
+
+            short events = 0;
+            if (t->sent < sizeof(uint64_t) + t->out_len)
+                events |= POLLOUT;
+            if (!t->in || t->received < t->in_len)
+                events |= POLLIN;
+
+            if (events) {
+                fds[nfds] = (struct pollfd){ .fd = worker->peers[p], .events = events };
+                ranks[nfds++] = p;
+            }
+        }
+
+        if (nfds == 0)
+            break;
+
+        if (poll(fds, nfds, -1) < 0)
+            GENERIC_ERROR("poll: error waiting for peers");
+
+        for (size_t i = 0; i < nfds; i++) {
+            Transfer *t = &transfers[ranks[i]];
+
+            if (fds[i].revents & POLLOUT) {
+                const char *data = t->sent < sizeof(uint64_t)
+                    ? (const char *)&t->out_len + t->sent
+                    : buckets[ranks[i]].data + (t->sent - sizeof(uint64_t));
+                size_t len = t->sent < sizeof(uint64_t)
+                    ? sizeof(uint64_t) - t->sent
+                    : t->out_len - (t->sent - sizeof(uint64_t));
+
+                ssize_t n = send(fds[i].fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (n > 0)
+                    t->sent += n;
+                else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    GENERIC_ERROR("send: error sending a bucket to a peer");
+            }
+
+            if (fds[i].revents & (POLLIN | POLLHUP)) {
+                ssize_t n;
+
+                if (!t->in) {
+                    n = recv(fds[i].fd, (char *)&t->in_len + t->received, sizeof(uint64_t) - t->received, MSG_DONTWAIT);
+                    if (n > 0 && (t->received += n) == sizeof(uint64_t)) {
+                        t->in = malloc(t->in_len + 1);
+                        if (!t->in)
+                            GENERIC_ERROR("malloc: memory allocation failed");
+                        t->in[t->in_len] = '\0';
+                        t->received = 0;
+                    }
+                } else {
+                    n = recv(fds[i].fd, t->in + t->received, t->in_len - t->received, MSG_DONTWAIT);
+                    if (n > 0)
+                        t->received += n;
+                }
+
+                if (n == 0)
+                    GENERIC_ERROR("recv: peer closed the connection during the exchange");
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                    GENERIC_ERROR("recv: error receiving a bucket from a peer");
+            }
+        }
+    }
+
+    char **received = malloc(workers * sizeof(char *));
+    if (!received)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t p = 0; p < workers; p++)
+        received[p] = transfers[p].in;
+
+    free(transfers);
+    free(fds);
+    free(ranks);
+
+    return received;
+}
+
+/**
+ * @brief Body of a worker process.
+ *
+ * The worker loads its shard, sends a strided sample of it to the coordinator, receives
+ * the splitters, routes every record to the worker owning its key range, sorts what it
+ * received and streams the sorted range back to the coordinator. Records are appended
+ * in source rank order before sorting, so stable algorithms give the same output as
+ * a single-process sort.
+ */
+static void run_worker(Worker *worker, const char *path, size_t field, size_t algo) {
+    int (*compar)(const void *, const void *) = record_comparator(field);
+    size_t count;
+    Record *records = load_shard(path, worker->rank, worker->workers, &count);
+
+    WireBuffer sample = {0};
+    size_t samples = count < DISTRIBUTED_SAMPLES ? count : DISTRIBUTED_SAMPLES;
+    for (size_t i = 0; i < samples; i++)
+        wire_append(&sample, &records[i * (count / samples)]);
+    send_message(worker->coordinator, sample.data ? sample.data : "", sample.len);
+    free(sample.data);
+
+    Record *splitters = NULL;
+    size_t nsplitters = 0, splitters_cap = 0;
+    char *text = recv_message(worker->coordinator);
+    wire_parse(text, &splitters, &nsplitters, &splitters_cap);
+    free(text);
+
+    WireBuffer *buckets = calloc(worker->workers, sizeof(WireBuffer));
+    if (!buckets)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    for (size_t i = 0; i < count; i++) {
+        size_t lo = 0, hi = nsplitters;
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (compar(&splitters[mid], &records[i]) <= 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        wire_append(&buckets[lo], &records[i]);
+        free(records[i].field_str);
+    }
+    free(records);
+
+    char **received = exchange_buckets(worker, buckets);
+    received[worker->rank] = buckets[worker->rank].data;
+
+    records = NULL;
+    size_t cap = 0;
+    count = 0;
+    for (size_t p = 0; p < worker->workers; p++) {
+        if (received[p])
+            wire_parse(received[p], &records, &count, &cap);
+        free(received[p]);
+        if (p != worker->rank)
+            free(buckets[p].data);
+    }
+
+    if (count > 0)
+        sort_record_array(records, count, field, algo);
+
+    FILE *out = fdopen(worker->coordinator, "w");
+    if (!out)
+        GENERIC_ERROR("fdopen: error opening coordinator stream");
+
+    save_records(out, records, count);
+    fclose(out);
+}
+
+/**
+ * @brief Picks the splitters from the samples of all workers and sends them out.
+ *
+ * The samples are sorted and the workers - 1 splitters taken at regular intervals,
+ * so that each key range receives about the same share of the records.
+ */
+static void broadcast_splitters(int *coordinator, size_t workers, size_t field) {
+    Record *samples = NULL;
+    size_t count = 0, cap = 0;
+
+    for (size_t w = 0; w < workers; w++) {
+        char *text = recv_message(coordinator[w]);
+        wire_parse(text, &samples, &count, &cap);
+        free(text);
+    }
+
+    WireBuffer splitters = {0};
+    if (count > 0) {
+        merge_sort(samples, count, sizeof(Record), record_comparator(field));
+
+        for (size_t w = 1; w < workers; w++)
+            wire_append(&splitters, &samples[w * count / workers]);
+    }
+
+    for (size_t w = 0; w < workers; w++)
+        send_message(coordinator[w], splitters.data ? splitters.data : "", splitters.len);
+
+    for (size_t i = 0; i < count; i++)
+        free(samples[i].field_str);
+    free(samples);
+    free(splitters.data);
+}
+
+/**
+ * @brief Sorts a CSV file with a sample sort spread over several worker processes.
+ *
+ * The coordinator forks the workers and connects them with Unix domain sockets: one to
+ * the coordinator each and a full mesh between the workers. Each worker loads a shard of
+ * the file, the coordinator chooses the splitters from the samples the workers send,
+ * the workers exchange records by key range and sort them locally, and the coordinator
+ * concatenates the sorted ranges in rank order. Only the sockets tie the processes
+ * together, so the same protocol carries over to workers running on other hosts.
+ *
+ * @param path The path of the input CSV file.
+ * @param outfile Pointer to the output file where sorted records will be saved.
+ * @param field The field number to sort by (1: string, 2: integer, 3: float).
+ * @param algo The sorting algorithm each worker uses locally (see sort_records).
+ * @param workers The number of worker processes.
+ */
+void distributed_sort(const char *path, FILE *outfile, size_t field, size_t algo, size_t workers) {
+    if (!path || !outfile)
+        GENERIC_ERROR("distributed_sort: file not provided");
+    if (workers == 0)
+        GENERIC_ERROR("distributed_sort: at least one worker is required");
+
+    record_comparator(field);
+
+    int *coordinator = malloc(workers * 2 * sizeof(int));
+    int *mesh = malloc(workers * workers * 2 * sizeof(int));
+    pid_t *pids = malloc(workers * sizeof(pid_t));
+    if (!coordinator || !mesh || !pids)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t w = 0; w < workers; w++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, &coordinator[2 * w]) != 0)
+            GENERIC_ERROR("socketpair: error connecting a worker");
+
+        for (size_t p = w + 1; p < workers; p++) {
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, &mesh[2 * (w * workers + p)]) != 0)
+                GENERIC_ERROR("socketpair: error connecting two workers");
+        }
+    }
+
+    fflush(NULL);
+
+    for (size_t w = 0; w < workers; w++) {
+        pids[w] = fork();
+        if (pids[w] < 0)
+            GENERIC_ERROR("fork: error starting a worker");
+        if (pids[w] > 0)
+            continue;
+
+        Worker worker = { .rank = w, .workers = workers, .coordinator = coordinator[2 * w + 1] };
+        worker.peers = malloc(workers * sizeof(int));
+        if (!worker.peers)
+            GENERIC_ERROR("malloc: memory allocation failed");
+
+        for (size_t i = 0; i < workers; i++) {
+            close(coordinator[2 * i]);
+            if (i != w)
+                close(coordinator[2 * i + 1]);
+
+            for (size_t p = i + 1; p < workers; p++) {
+                int *pair = &mesh[2 * (i * workers + p)];
+
+                if (i == w)
+                    worker.peers[p] = pair[0];
+                else
+                    close(pair[0]);
+
+                if (p == w)
+                    worker.peers[i] = pair[1];
+                else
+                    close(pair[1]);
+            }
+        }
+
+        run_worker(&worker, path, field, algo);
+        exit(EXIT_SUCCESS);
+    }
+
+    for (size_t w = 0; w < workers; w++) {
+        close(coordinator[2 * w + 1]);
+        coordinator[w] = coordinator[2 * w];
+
+        for (size_t p = w + 1; p < workers; p++) {
+            close(mesh[2 * (w * workers + p)]);
+            close(mesh[2 * (w * workers + p) + 1]);
+        }
+    }
+
+    broadcast_splitters(coordinator, workers, field);
+
+    char buffer[BUFSIZ * 16];
+    for (size_t w = 0; w < workers; w++) {
+        ssize_t n;
+
+        while ((n = read(coordinator[w], buffer, sizeof(buffer))) > 0) {
+            if (fwrite(buffer, 1, n, outfile) != (size_t)n)
+                GENERIC_ERROR("fwrite: error writing to output file");
+        }
+        if (n < 0)
+            GENERIC_ERROR("read: error receiving sorted records");
+
+        close(coordinator[w]);
+    }
+
+    for (size_t w = 0; w < workers; w++) {
+        int status;
+
+        if (waitpid(pids[w], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+            GENERIC_ERROR("distributed_sort: a worker failed");
+    }
+
+    free(coordinator);
+    free(mesh);
+    free(pids);
+}
@@ -0,0 +1,300 @@
+#include "../include/utils.h"
+#include <pthread.h>
+#include <zlib.h>
+
+// size of each block of uncompressed data in the ring
+#define GZIP_BLOCK_BYTES (256 * 1024)
+// number of blocks in the ring
+#define GZIP_RING_BLOCKS 8
+// compressed bytes read or written at a time
+#define GZIP_IO_BYTES (64 * 1024)
+
+/**
+ * Ring of uncompressed blocks shared by the caller and the (de)compression thread.
+ * Block i is owned by the producer while full[i] is 0 and by the consumer otherwise.
+ */
+struct GzipStream {
+    FILE *file;
+    z_stream zs;
+    char *blocks[GZIP_RING_BLOCKS];
+    size_t lengths[GZIP_RING_BLOCKS];
+    int full[GZIP_RING_BLOCKS];
+    size_t current;     // block being consumed (reader) or filled (writer)
+    int started;        // the reader returned a first block
+    int finished;       // the producer has no more blocks
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+/**
+ * @brief Tells whether a stream starts with the gzip magic bytes, without moving it.
+ */
+int gzip_detect(FILE *file) {
+    if (!file)
+        GENERIC_ERROR("gzip_detect: file not provided");
+
+    off_t start = ftello(file);
+    unsigned char magic[2];
+    size_t n = fread(magic, 1, sizeof(magic), file);
+
+    if (start < 0 || fseeko(file, start, SEEK_SET) != 0)
+        GENERIC_ERROR("fseeko: error rewinding input file");
+
+    return n == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+static GzipStream *gzip_alloc(FILE *file) {
+    GzipStream *gz = calloc(1, sizeof(GzipStream));
+    if (!gz)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    gz->file = file;
+    for (size_t b = 0; b < GZIP_RING_BLOCKS; b++) {
+        gz->blocks[b] = malloc(GZIP_BLOCK_BYTES);
+        if (!gz->blocks[b])
+            GENERIC_ERROR("malloc: memory allocation failed");
+    }
+    pthread_mutex_init(&gz->lock, NULL);
+    pthread_cond_init(&gz->changed, NULL);
+
+    return gz;
+}
+
+static void gzip_free(GzipStream *gz) {
+    for (size_t b = 0; b < GZIP_RING_BLOCKS; b++)
+        free(gz->blocks[b]);
+    pthread_mutex_destroy(&gz->lock);
+    pthread_cond_destroy(&gz->changed);
+    free(gz);
+}
+
+// waits until block b is in the wanted state, or the other side is done
+static void wait_block(GzipStream *gz, size_t b, int full) {
+    pthread_mutex_lock(&gz->lock);
+    while (gz->full[b] != full && !(full && gz->finished))
+        pthread_cond_wait(&gz->changed, &gz->lock);
+    pthread_mutex_unlock(&gz->lock);
+}
+
+static void set_block(GzipStream *gz, size_t b, int full) {
+    pthread_mutex_lock(&gz->lock);
+    gz->full[b] = full;
+    pthread_cond_broadcast(&gz->changed);
+    pthread_mutex_unlock(&gz->lock);
+}
+
+static void set_finished(GzipStream *gz) {
+    pthread_mutex_lock(&gz->lock);
+    gz->finished = 1;
+    pthread_cond_broadcast(&gz->changed);
+    pthread_mutex_unlock(&gz->lock);
+}
+
+/**
+ * @brief Body of the decompression thread: inflates the file block by block into the ring.
+ *
+ * Concatenated gzip members, as produced by `cat a.gz b.gz`, are decompressed one after
+ * the other, like gzip -d does.
+ */
+static void *inflate_thread(void *arg) {
+    GzipStream *gz = arg;
+    unsigned char in[GZIP_IO_BYTES];
+    size_t b = 0;
+    int status = Z_OK;
+
+    for (;;) {
+        wait_block(gz, b, 0);
+
+        gz->zs.next_out = (Bytef *)gz->blocks[b];
+        gz->zs.avail_out = GZIP_BLOCK_BYTES;
+
+        while (gz->zs.avail_out > 0) {
+            if (gz->zs.avail_in == 0) {
+                gz->zs.avail_in = (uInt)fread(in, 1, sizeof(in), gz->file);
+                gz->zs.next_in = in;
+                if (gz->zs.avail_in == 0) {
+                    if (ferror(gz->file))
+                        GENERIC_ERROR("fread: error reading compressed input");
+                    if (status != Z_STREAM_END)
+                        GENERIC_ERROR("inflate: truncated gzip input");
+                    break;
+                }
+            }
+
+            if (status == Z_STREAM_END && inflateReset(&gz->zs) != Z_OK)
+                GENERIC_ERROR("inflateReset: error starting the next gzip member");
+
+            status = inflate(&gz->zs, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END)
+                GENERIC_ERROR("inflate: corrupted gzip input");
+        }
+
+        gz->lengths[b] = GZIP_BLOCK_BYTES - gz->zs.avail_out;
+        if (gz->lengths[b] == 0)
+            break;
+
+        set_block(gz, b, 1);
+        b = (b + 1) % GZIP_RING_BLOCKS;
+    }
+
+    set_finished(gz);
+    return NULL;
+}
+
+/**
+ * @brief Starts decompressing a gzip stream on a dedicated thread.
+ *
+ * The thread keeps up to GZIP_RING_BLOCKS blocks of uncompressed data ahead of the
+ * caller, so that inflating overlaps with whatever the caller does with the blocks.
+ *
+ * @param file The compressed stream, positioned at the gzip header.
+ * @return The reader, to be released with gzip_reader_close().
+ */
+GzipStream *gzip_reader_open(FILE *file) {
+    if (!file)
+        GENERIC_ERROR("gzip_reader_open: file not provided");
+
+    GzipStream *gz = gzip_alloc(file);
+
+    // 16 + MAX_WBITS: gzip wrapper only
+    if (inflateInit2(&gz->zs, 16 + MAX_WBITS) != Z_OK)
+        GENERIC_ERROR("inflateInit2: error initializing zlib");
+
+    if (pthread_create(&gz->thread, NULL, inflate_thread, gz) != 0)
+        GENERIC_ERROR("pthread_create: error starting the decompression thread");
+
+    return gz;
+}
+
+/**
+ * @brief Returns the next block of uncompressed data.
+ *
+ * The block may be modified by the caller and stays valid until the next call, which
+ * hands it back to the decompression thread.
+ *
+ * @param gz The reader.
+ * @param len Pointer to the number of bytes in the block.
+ * @return Pointer to the block, or NULL at the end of the data.
+ */
+char *gzip_reader_next(GzipStream *gz, size_t *len) {
+    if (gz->started) {
+        set_block(gz, gz->current, 0);
+        gz->current = (gz->current + 1) % GZIP_RING_BLOCKS;
+    }
+    gz->started = 1;
+
+    wait_block(gz, gz->current, 1);
+    if (!gz->full[gz->current])
+        return NULL;
+
+    *len = gz->lengths[gz->current];
+    return gz->blocks[gz->current];
+}
+
+/**
+ * @brief Stops the decompression thread and releases the reader.
+ *
+ * The caller must have read up to the end of the data.
+ */
+void gzip_reader_close(GzipStream *gz) {
+    pthread_join(gz->thread, NULL);
+    inflateEnd(&gz->zs);
+    gzip_free(gz);
+}
+
+static void deflate_block(GzipStream *gz, const char *data, size_t len, int flush) {
+    unsigned char out[GZIP_IO_BYTES];
+
+    gz->zs.next_in = (Bytef *)data;
+    gz->zs.avail_in = (uInt)len;
+    do {
+        gz->zs.next_out = out;
+        gz->zs.avail_out = sizeof(out);
+
+        if (deflate(&gz->zs, flush) == Z_STREAM_ERROR)
+            GENERIC_ERROR("deflate: error compressing output");
+
+        size_t produced = sizeof(out) - gz->zs.avail_out;
+        if (fwrite(out, 1, produced, gz->file) != produced)
+            GENERIC_ERROR("fwrite: error writing compressed output");
+    } while (gz->zs.avail_out == 0);
+}
+
+/**
+ * @brief Body of the compression thread: deflates the blocks the caller fills, in order.
+ */
+static void *deflate_thread(void *arg) {
+    GzipStream *gz = arg;
+    size_t b = 0;
+
+    for (;;) {
+        wait_block(gz, b, 1);
+        if (!gz->full[b])
+            break;
+
+        deflate_block(gz, gz->blocks[b], gz->lengths[b], Z_NO_FLUSH);
+        set_block(gz, b, 0);
+        b = (b + 1) % GZIP_RING_BLOCKS;
+    }
+
+    deflate_block(gz, NULL, 0, Z_FINISH);
+    return NULL;
+}
+
+/**
+ * @brief Starts compressing to a gzip stream on a dedicated thread.
+ *
+ * @param file The stream receiving the compressed data.
+ * @return The writer, to be released with gzip_writer_close().
+ */
+GzipStream *gzip_writer_open(FILE *file) {
+    if (!file)
+        GENERIC_ERROR("gzip_writer_open: file not provided");
+
+    GzipStream *gz = gzip_alloc(file);
+
+    // the default level keeps compression fast enough to hide behind formatting
+    if (deflateInit2(&gz->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        GENERIC_ERROR("deflateInit2: error initializing zlib");
+
+    if (pthread_create(&gz->thread, NULL, deflate_thread, gz) != 0)
+        GENERIC_ERROR("pthread_create: error starting the compression thread");
+
+    return gz;
+}
+
+void gzip_writer_write(GzipStream *gz, const char *data, size_t len) {
+    while (len > 0) {
+        size_t b = gz->current;
+        size_t n = GZIP_BLOCK_BYTES - gz->lengths[b];
+        if (n > len)
+            n = len;
+
+        memcpy(gz->blocks[b] + gz->lengths[b], data, n);
+        gz->lengths[b] += n;
+        data += n;
+        len -= n;
+
+        if (gz->lengths[b] == GZIP_BLOCK_BYTES) {
+            set_block(gz, b, 1);
+            gz->current = (b + 1) % GZIP_RING_BLOCKS;
+
+            wait_block(gz, gz->current, 0);
+            gz->lengths[gz->current] = 0;
+        }
+    }
+}
+
+/**
+ * @brief Compresses what is left, writes the gzip trailer and releases the writer.
+ */
+void gzip_writer_close(GzipStream *gz) {
+    if (gz->lengths[gz->current] > 0)
+        set_block(gz, gz->current, 1);
+    set_finished(gz);
+
+    pthread_join(gz->thread, NULL);
+    deflateEnd(&gz->zs);
+    gzip_free(gz);
+}
@@ -0,0 +1,518 @@
+#include "../include/utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+// size of each read or write kept in flight
+#define IO_CHUNK_BYTES (1 << 20)
+// number of chunks in flight
+#define IO_QUEUE_DEPTH 4
+// buffer, offset and length alignment required by O_DIRECT
+#define IO_ALIGN 4096
+
+/**
+ * Minimal io_uring instance driven through the raw system calls: the submission
+ * and completion rings shared with the kernel, and the submission entries.
+ */
+typedef struct {
+    int fd;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map;
+    void *cq_map;
+    size_t sq_map_size;
+    size_t cq_map_size;
+    size_t sqes_size;
+} IoRing;
+
+/**
+ * One chunk buffer and the request that fills or drains it.
+ */
+typedef struct {
+    char *data;
+    size_t len;         // bytes requested (0 when the slot is idle)
+    uint64_t offset;
+    int pending;        // submitted to the ring, completion not reaped yet
+    int result;
+} IoSlot;
+
+struct IoFile {
+    FILE *file;
+    int fd;
+    int flags;          // file status flags to restore on close
+    int direct;
+    int use_ring;
+    int writing;        // completions are writes, checked as soon as they are reaped
+    IoRing ring;
+    IoSlot slots[IO_QUEUE_DEPTH];
+    size_t current;     // slot returned by the last read, or being filled by writes
+    uint64_t start;     // position of the stream when the backend took over
+    uint64_t size;      // size of the file being read
+    uint64_t next;      // offset of the next chunk to request
+    uint64_t position;  // logical position reached by the writes
+};
+
+// whether io_uring can serve reads and writes, probed once per process
+static pthread_once_t ring_probe_once = PTHREAD_ONCE_INIT;
+static int ring_supported = 0;
+static int direct_requested = 0;
+
+/**
+ * @brief Asks the backend to bypass the page cache with O_DIRECT when the file system allows it.
+ */
+void io_backend_set_direct(int enable) {
+    direct_requested = enable;
+}
+
+static int ring_setup(IoRing *ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+        return -1;
+
+    ring->fd = fd;
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_map_size > ring->sq_map_size)
+            ring->sq_map_size = ring->cq_map_size;
+        ring->cq_map_size = ring->sq_map_size;
+    }
+
+    ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    ring->cq_map = ring->sq_map;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        ring->cq_map = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) {
+            munmap(ring->sq_map, ring->sq_map_size);
+            close(fd);
+            return -1;
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_map != ring->sq_map)
+            munmap(ring->cq_map, ring->cq_map_size);
+        munmap(ring->sq_map, ring->sq_map_size);
+        close(fd);
+        return -1;
+    }
+
+    char *sq = ring->sq_map;
+    char *cq = ring->cq_map;
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    return 0;
+}
+
+static void ring_free(IoRing *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_map != ring->sq_map)
+        munmap(ring->cq_map, ring->cq_map_size);
+    munmap(ring->sq_map, ring->sq_map_size);
+    close(ring->fd);
+}
+
+/**
+ * @brief Checks that the running kernel offers io_uring with plain reads and writes.
+ *
+ * Kernels before 5.6 lack IORING_OP_READ and IORING_OP_WRITE, and containers often
+ * forbid io_uring_setup altogether; either way the backend falls back to pread and pwrite.
+ * Runs once per process through pthread_once(), since readers and writers are opened
+ * from several threads at a time (see sort_records_batch).
+ */
+static void ring_probe_run(void) {
+    IoRing ring;
+    if (ring_setup(&ring, IO_QUEUE_DEPTH) != 0)
+        return ;
+
+    size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, probe_size);
+    if (!probe)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, 256) == 0
+        && probe->last_op >= IORING_OP_WRITE
+        && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)
+        && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED))
+        ring_supported = 1;
+
+    free(probe);
+    ring_free(&ring);
+}
+
+static int ring_probe(void) {
+    pthread_once(&ring_probe_once, ring_probe_run);
+
+    return ring_supported;
+}
+
+static void ring_submit(IoRing *ring, int opcode, int fd, IoSlot *slot, uint64_t tag) {
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (uint8_t)opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)slot->data;
+    sqe->len = (uint32_t)slot->len;
+    sqe->off = slot->offset;
+    sqe->user_data = tag;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    slot->pending = 1;
+    while (syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0) != 1) {
+        if (errno != EINTR && errno != EAGAIN)
+            GENERIC_ERROR("io_uring_enter: error submitting a request");
+    }
+}
+
+// continues a partial transfer through the page cache when the rest is not block-aligned,
+// which O_DIRECT would reject
+static void leave_direct(IoFile *io, size_t done) {
+    if (io->direct && done % IO_ALIGN != 0) {
+        fcntl(io->fd, F_SETFL, io->flags);
+        io->direct = 0;
+    }
+}
+
+// completes a partial transfer synchronously; regular files only do so near the end of file.
+// Whole chunks are asked for, so that O_DIRECT sees aligned lengths.
+static void finish_read(IoFile *io, IoSlot *slot, size_t done, size_t expected) {
+    leave_direct(io, done);
+
+    while (done < expected) {
+        ssize_t n = pread(io->fd, slot->data + done, IO_CHUNK_BYTES - done, slot->offset + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            GENERIC_ERROR("pread: error reading input file");
+        done += n;
+    }
+}
+
+static void finish_write(IoFile *io, IoSlot *slot, size_t done) {
+    if (done < slot->len)
+        leave_direct(io, done);
+
+    while (done < slot->len) {
+        ssize_t n = pwrite(io->fd, slot->data + done, slot->len - done, slot->offset + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            GENERIC_ERROR("pwrite: error writing to output file");
+        done += n;
+    }
+}
+
+/**
+ * @brief Reaps one completion, blocking until there is one.
+ *
+ * Completions arrive in any order, so the one reaped may belong to another slot than
+ * the one waited for. A write is therefore checked, and a short one finished, right
+ * here: no later wait would see it pending again.
+ */
+static void ring_reap(IoFile *io) {
+    IoRing *ring = &io->ring;
+
+    for (;;) {
+        unsigned head = *ring->cq_head;
+
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            IoSlot *slot = &io->slots[cqe->user_data];
+
+            slot->result = cqe->res;
+            slot->pending = 0;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+            if (io->writing) {
+                if (slot->result < 0)
+                    GENERIC_ERROR("io_uring: error writing to output file");
+                finish_write(io, slot, slot->result);
+            }
+            return;
+        }
+
+        if (syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+            GENERIC_ERROR("io_uring_enter: error waiting for a completion");
+    }
+}
+
+static void wait_slot(IoFile *io, size_t s) {
+    while (io->slots[s].pending)
+        ring_reap(io);
+}
+
+/**
+ * @brief Takes over the descriptor of a stdio stream, or returns NULL if it is not a regular file.
+ */
+static IoFile *io_open(FILE *file, uint64_t start, struct stat *st) {
+    int fd = fileno(file);
+    if (fd < 0 || fstat(fd, st) != 0 || !S_ISREG(st->st_mode))
+        return NULL;
+
+    IoFile *io = calloc(1, sizeof(IoFile));
+    if (!io)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    io->file = file;
+    io->fd = fd;
+    io->start = start;
+    io->flags = fcntl(fd, F_GETFL);
+    io->use_ring = ring_probe() && ring_setup(&io->ring, IO_QUEUE_DEPTH) == 0;
+
+    // O_DIRECT needs aligned offsets; file systems without it reject the flag
+    if (direct_requested && io->flags >= 0 && start % IO_ALIGN == 0)
+        io->direct = fcntl(fd, F_SETFL, io->flags | O_DIRECT) == 0;
+
+    for (size_t s = 0; s < IO_QUEUE_DEPTH; s++) {
+        if (posix_memalign((void **)&io->slots[s].data, IO_ALIGN, IO_CHUNK_BYTES) != 0)
+            GENERIC_ERROR("posix_memalign: memory allocation failed");
+    }
+
+    return io;
+}
+
+static void io_free(IoFile *io) {
+    if (io->direct)
+        fcntl(io->fd, F_SETFL, io->flags);
+    if (io->use_ring)
+        ring_free(&io->ring);
+    for (size_t s = 0; s < IO_QUEUE_DEPTH; s++)
+        free(io->slots[s].data);
+    free(io);
+}
+
+// requests the next chunk of the file into slot s, if any is left
+static void request_chunk(IoFile *io, size_t s) {
+    IoSlot *slot = &io->slots[s];
+
+    slot->len = 0;
+    if (io->next >= io->size)
+        return;
+
+    slot->offset = io->next;
+    slot->len = IO_CHUNK_BYTES;
+    io->next += IO_CHUNK_BYTES;
+
+    if (io->use_ring) {
+        ring_submit(&io->ring, IORING_OP_READ, io->fd, slot, s);
+    } else {
+        size_t expected = io->size - slot->offset < IO_CHUNK_BYTES ? io->size - slot->offset : IO_CHUNK_BYTES;
+
+        finish_read(io, slot, 0, expected);
+        slot->result = (int)expected;
+    }
+}
+
+/**
+ * @brief Opens a stream for chunked reads from its current position to the end of the file.
+ *
+ * With io_uring, IO_QUEUE_DEPTH reads of IO_CHUNK_BYTES are kept in flight, so the kernel
+ * fetches ahead while the caller parses; otherwise every chunk is a blocking pread.
+ *
+ * @param file The stream to read; its position is restored by io_reader_close().
+ * @return The reader, or NULL if the stream is not a regular file (use stdio instead).
+ */
+IoFile *io_reader_open(FILE *file) {
+    if (!file)
+        GENERIC_ERROR("io_reader_open: file not provided");
+
+    off_t start = ftello(file);
+    if (start < 0)
+        return NULL;
+
+    struct stat st;
+    IoFile *io = io_open(file, (uint64_t)start, &st);
+    if (!io)
+        return NULL;
+
+    io->size = (uint64_t)st.st_size;
+    io->next = io->start;
+    for (size_t s = 0; s < IO_QUEUE_DEPTH; s++)
+        request_chunk(io, s);
+    io->current = IO_QUEUE_DEPTH;
+
+    return io;
+}
+
+/**
+ * @brief Returns the next chunk of the file, in order.
+ *
+ * The chunk may be modified by the caller and stays valid until the next call, which
+ * hands its buffer back to the kernel for a read further ahead.
+ *
+ * @param io The reader.
+ * @param len Pointer to the number of bytes in the chunk.
+ * @return Pointer to the chunk, or NULL at the end of the file.
+ */
+char *io_reader_next(IoFile *io, size_t *len) {
+    size_t s = io->current == IO_QUEUE_DEPTH ? 0 : (io->current + 1) % IO_QUEUE_DEPTH;
+
+    if (io->current != IO_QUEUE_DEPTH)
+        request_chunk(io, io->current);
+    io->current = s;
+
+    IoSlot *slot = &io->slots[s];
+    if (slot->len == 0)
+        return NULL;
+
+    size_t expected = io->size - slot->offset < IO_CHUNK_BYTES ? io->size - slot->offset : IO_CHUNK_BYTES;
+    if (io->use_ring) {
+        wait_slot(io, s);
+        if (slot->result < 0)
+            GENERIC_ERROR("io_uring: error reading input file");
+        if ((size_t)slot->result < expected)
+            finish_read(io, slot, slot->result, expected);
+    }
+
+    *len = expected;
+    return slot->data;
+}
+
+/**
+ * @brief Releases a reader, leaving the stream positioned after the bytes the caller used.
+ *
+ * @param io The reader.
+ * @param consumed The number of bytes consumed since io_reader_open().
+ */
+void io_reader_close(IoFile *io, uint64_t consumed) {
+    if (io->use_ring) {
+        for (size_t s = 0; s < IO_QUEUE_DEPTH; s++)
+            wait_slot(io, s);
+    }
+
+    if (fseeko(io->file, (off_t)(io->start + consumed), SEEK_SET) != 0)
+        GENERIC_ERROR("fseeko: error repositioning input file");
+
+    io_free(io);
+}
+
+// sends the filled slot to the file and moves to the next one, waiting until it is free
+static void flush_chunk(IoFile *io) {
+    IoSlot *slot = &io->slots[io->current];
+
+    if (io->use_ring)
+        ring_submit(&io->ring, IORING_OP_WRITE, io->fd, slot, io->current);
+    else
+        finish_write(io, slot, 0);
+
+    io->current = (io->current + 1) % IO_QUEUE_DEPTH;
+    slot = &io->slots[io->current];
+
+    if (io->use_ring)
+        wait_slot(io, io->current);
+
+    slot->offset = io->position;
+    slot->len = 0;
+}
+
+/**
+ * @brief Opens a stream for chunked writes at its current position.
+ *
+ * Writes are gathered into IO_CHUNK_BYTES buffers; with io_uring up to IO_QUEUE_DEPTH
+ * of them are written while the caller keeps filling the next one.
+ *
+ * @param file The stream to write; pending stdio output is flushed first.
+ * @return The writer, or NULL if the stream is not a regular file (use stdio instead).
+ */
+IoFile *io_writer_open(FILE *file) {
+    if (!file)
+        GENERIC_ERROR("io_writer_open: file not provided");
+
+    if (fflush(file) != 0)
+        GENERIC_ERROR("fflush: error writing to output file");
+
+    off_t start = ftello(file);
+    if (start < 0)
+        return NULL;
+
+    struct stat st;
+    IoFile *io = io_open(file, (uint64_t)start, &st);
+    if (!io)
+        return NULL;
+
+    io->writing = 1;
+    io->position = io->start;
+    io->slots[0].offset = io->start;
+
+    return io;
+}
+
+void io_writer_write(IoFile *io, const char *data, size_t len) {
+    while (len > 0) {
+        IoSlot *slot = &io->slots[io->current];
+        size_t room = IO_CHUNK_BYTES - slot->len;
+        size_t n = len < room ? len : room;
+
+        memcpy(slot->data + slot->len, data, n);
+        slot->len += n;
+        io->position += n;
+        data += n;
+        len -= n;
+
+        if (slot->len == IO_CHUNK_BYTES)
+            flush_chunk(io);
+    }
+}
+
+/**
+ * @brief Returns the position in the file where the next written byte will land.
+ */
+uint64_t io_writer_tell(const IoFile *io) {
+    return io->position;
+}
+
+/**
+ * @brief Writes what is left, waits for every write in flight and releases the writer.
+ *
+ * The stream is left positioned after the written bytes, so stdio output can follow.
+ */
+void io_writer_close(IoFile *io) {
+    if (io->use_ring) {
+        for (size_t s = 0; s < IO_QUEUE_DEPTH; s++)
+            wait_slot(io, s);
+    }
+
+    // the tail is rarely a multiple of the block size, so it goes through the page cache
+    if (io->direct) {
+        fcntl(io->fd, F_SETFL, io->flags);
+        io->direct = 0;
+    }
+    finish_write(io, &io->slots[io->current], 0);
+
+    if (fseeko(io->file, (off_t)io->position, SEEK_SET) != 0)
+        GENERIC_ERROR("fseeko: error repositioning output file");
+
+    io_free(io);
+}
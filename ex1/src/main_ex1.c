@@ -1,179 +1,277 @@
 #include "../include/utils.h"
-
-static int compare_field_int(const void *a, const void *b) {
-    ARGUMENTS_ERROR(a, b);
-
-    Record *x = (Record *)a;
-    Record *y = (Record *)b;
-
-    return x->field_int - y->field_int;
-}
-
-static int compare_field_str(const void *a, const void *b) {
-    ARGUMENTS_ERROR(a, b);
-
-    Record *x = (Record *)a;
-    Record *y = (Record *)b;
-
-    return strcmp(x->field_str, y->field_str);
-}
-
-static int compare_field_float(const void *a, const void *b) {
-    ARGUMENTS_ERROR(a, b);
-
-    Record *x = (Record *)a;
-    Record *y = (Record *)b;
-
-    return (x->field_fp > y->field_fp) - (x->field_fp < y->field_fp);
-}
+#include <getopt.h>
 
 /**
- * @brief Counts the number of lines in a given file.
+ * @brief Sorts records from an input file and saves the sorted results to an output file.
  * 
- * This function reads the given file line by line and counts the total number of lines.
- * It then resets the file position to the beginning of the file.
+ * This function reads records from the input file, sorts them based on the specified field
+ * and sorting algorithm, and then saves the sorted records to the output file.
  * 
- * @param infile Pointer to the file to be read.
- * @return The number of lines in the file.
+ * @param infile Pointer to the input file containing records to be sorted (plain or gzip).
+ * @param outfile Pointer to the output file where sorted records will be saved.
+ * @param field The field number to sort by (1: string, 2: integer, 3: float).
+ * @param algo The sorting algorithm to use (0: automatic, 1: merge sort, 2: quicksort,
+ *             3: multiway merge sort, 4: in-place merge sort).
  */
-static size_t count_lines(FILE *infile) {
-    if (!infile) 
-        GENERIC_ERROR("count_lines: infile not provided");
-    
-    size_t count = 0; 
-    char buffer[BUFSIZ];
-
-    while(fgets(buffer, sizeof(buffer), infile))
-        count++;
-
-    if (fseek(infile, 0, SEEK_SET) != 0)
-        GENERIC_ERROR("fseek: Error resetting file");
-    
-    return count;
+void sort_records(FILE *infile, FILE *outfile, size_t field, size_t algo) {
+    sort_records_indexed(infile, outfile, field, algo, 0, NULL);
 }
 
 /**
- * @brief Loads records from a given file.
+ * @brief Sorts records like sort_records() and optionally writes a sparse index sidecar.
  * 
- * This function reads the specified number of lines from the file and parses each line
- * into a Record structure. The records are stored in an array which is returned.
+ * With a positive stride, every stride-th key of the sorted output and the position of
+ * its line are saved to index_path, so that range queries can seek into the output
+ * instead of scanning it (see query_ex1).
  * 
- * @param infile Pointer to the file to be read.
- * @param lines The number of lines to read from the file.
- * @return Pointer to an array of records.
+ * @param infile Pointer to the input file containing records to be sorted.
+ * @param outfile Pointer to the output file where sorted records will be saved.
+ * @param field The field number to sort by (1: string, 2: integer, 3: float).
+ * @param algo The sorting algorithm to use (see sort_records).
+ * @param stride The number of lines between two indexed keys (0 for no index).
+ * @param index_path The path of the index file (unused when stride is 0).
  */
-static Record *load_records(FILE *infile, size_t lines) {
-    if (!infile) 
-        GENERIC_ERROR("load_records: file not provided");
-    
-    Record *records = malloc(lines * sizeof(Record));
-    if (!records) 
-        GENERIC_ERROR("malloc: memory allocation failed");
+void sort_records_indexed(FILE *infile, FILE *outfile, size_t field, size_t algo, size_t stride, const char *index_path) {
+    if (!infile || !outfile) 
+        GENERIC_ERROR("sort_records: file not provided");
+    if (stride > 0 && !index_path)
+        GENERIC_ERROR("sort_records_indexed: index path not provided");
+
+    size_t lines;
+    Record *records = read_records(infile, &lines);
     
-    char buffer[BUFSIZ];
-    for(size_t i = 0; fgets(buffer, sizeof(buffer), infile) && i < lines; i++) {
-        Record temp_record = {
-            atoi(strtok(buffer, ",")),
-            strdup(strtok(NULL, ",")),
-            atoi(strtok(NULL, ",")),
-            atof(strtok(NULL, ","))
-        };
-        records[i] = temp_record; 
+    sort_record_array(records, lines, field, algo);
+
+    if (stride == 0) {
+        save_records(outfile, records, lines);
+        return ;
     }
 
-    return records;
+    uint64_t *offsets = malloc(((lines + stride - 1) / stride + 1) * sizeof(uint64_t));
+    if (!offsets)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    save_records_sampled(outfile, records, lines, stride, offsets);
+
+    SparseIndex *index = sparse_index_build(records, lines, field, stride, offsets);
+    sparse_index_write(index, index_path);
+
+    sparse_index_free(index);
+    free(offsets);
 }
 
 /**
- * @brief Saves records to a given file.
- * 
- * This function writes the specified number of records to the given file. Each record is written
- * in a comma-separated format.
+ * @brief Sorts records like sort_records() and saves them gzip-compressed.
  * 
- * @param outfile Pointer to the file to be written to.
- * @param saved_records Pointer to the array of records to be saved.
- * @param lines The number of records to write.
+ * @param infile Pointer to the input file containing records to be sorted (plain or gzip).
+ * @param outfile Pointer to the output file where the compressed records will be saved.
+ * @param field The field number to sort by (1: string, 2: integer, 3: float).
+ * @param algo The sorting algorithm to use (see sort_records).
  */
-static void save_records(FILE *outfile, Record *saved_records, size_t lines) {
-    if (!outfile) 
-        GENERIC_ERROR("save_records: outfile file not provided");
-
-    for (size_t i = 0; i < lines; i++) {
-        if (fprintf(outfile, "%d,%s,%d,%f\n",
-                    saved_records[i].id,
-                    saved_records[i].field_str,
-                    saved_records[i].field_int,
-                    saved_records[i].field_fp) < 0) {
-            GENERIC_ERROR("fprintf: error writing to output file");
-        }
-    }
+void sort_records_compressed(FILE *infile, FILE *outfile, size_t field, size_t algo) {
+    if (!infile || !outfile)
+        GENERIC_ERROR("sort_records_compressed: file not provided");
+
+    size_t lines;
+    Record *records = read_records(infile, &lines);
+
+    sort_record_array(records, lines, field, algo);
+    save_records_gzip(outfile, records, lines);
+}
+
+// parses the <algo> argument: only the ids 0 to 4 listed in sort_records() are accepted
+static size_t parse_algo(const char *text) {
+    char *end;
+    unsigned long algo = strtoul(text, &end, 10);
+
+    if (end == text || *end != '\0' || algo > 4)
+        GENERIC_ERROR("Error: <algo> must be 0 (automatic), 1, 2, 3 or 4");
+
+    return (size_t)algo;
 }
 
 /**
- * @brief Sorts records from an input file and saves the sorted results to an output file.
- * 
- * This function reads records from the input file, sorts them based on the specified field
- * and sorting algorithm, and then saves the sorted records to the output file.
- * 
- * @param infile Pointer to the input file containing records to be sorted.
- * @param outfile Pointer to the output file where sorted records will be saved.
- * @param field The field number to sort by (1: string, 2: integer, 3: float).
- * @param algo The sorting algorithm to use (1: merge sort, 2: quicksort).
+ * @brief Runs the --batch mode: <input_csv> <algo> <field>:<output_csv> [...].
  */
-void sort_records(FILE *infile, FILE *outfile, size_t field, size_t algo) {
-    if (!infile || !outfile) 
-        GENERIC_ERROR("sort_records: file not provided");
+static void run_batch(int argc, char *argv[]) {
+    if (argc < 3)
+        GENERIC_ERROR("Usage: bin/main_ex1 --batch <input_csv[.gz]> <algo> <field>:<output_csv> [<field>:<output_csv> ...]");
 
-    size_t lines = count_lines(infile);
+    size_t algo = parse_algo(argv[1]);
+    size_t count = argc - 2;
+    size_t *fields = malloc(count * sizeof(size_t));
+    FILE **outfiles = malloc(count * sizeof(FILE *));
+    if (!fields || !outfiles)
+        GENERIC_ERROR("malloc: memory allocation failed");
 
-    Record *records = load_records(infile, lines);
-    
-    int (*compar)(const void *, const void *);
-    switch (field) {
-        case 1:
-            compar = compare_field_str;
-            break;
-        case 2:
-            compar = compare_field_int;
-            break;
-        case 3:
-            compar = compare_field_float;
-            break;
-        default:
-            GENERIC_ERROR("Error: invalid field number");
+    for (size_t i = 0; i < count; i++) {
+        char *path;
+
+        fields[i] = strtoul(argv[i + 2], &path, 10);
+        if (*path != ':' || path[1] == '\0')
+            GENERIC_ERROR("Error: batch outputs must be given as <field>:<output_csv>");
     }
 
-    switch (algo) {
-        case 1:
-            merge_sort(records, lines, sizeof(Record), compar);
-            break;
-        case 2:
-            quick_sort(records, lines, sizeof(Record), compar);
-            break;
-        default:
-            GENERIC_ERROR("Error: invalid algorithm id");
+    FILE *infile = fopen(argv[0], "r");
+    if (!infile)
+        GENERIC_ERROR("fopen: error opening input file");
+
+    // the outputs are truncated only once every argument checked out
+    for (size_t i = 0; i < count; i++) {
+        outfiles[i] = fopen(strchr(argv[i + 2], ':') + 1, "w+");
+        if (!outfiles[i])
+            GENERIC_ERROR("fopen: error opening output file");
     }
 
-    save_records(outfile, records, lines);
+    sort_records_batch(infile, fields, outfiles, count, algo);
+
+    fclose(infile);
+    for (size_t i = 0; i < count; i++)
+        fclose(outfiles[i]);
+    free(fields);
+    free(outfiles);
 }
 
 int main(int argc, char *argv[]) {
-    if(argc != 5) 
-        GENERIC_ERROR("Usage: bin/main_ex1 <input_csv> <output_csv> <field> <algo>");
+    static const struct option options[] = {
+        { "workers", required_argument, NULL, 'w' },
+        { "batch", no_argument, NULL, 'b' },
+        { "index", required_argument, NULL, 'i' },
+        { "merge-into", required_argument, NULL, 'm' },
+        { "pipeline", no_argument, NULL, 'p' },
+        { "direct-io", no_argument, NULL, 'd' },
+        { "project", no_argument, NULL, 'k' },
+        { "stats", no_argument, NULL, 's' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *usage = "Usage: bin/main_ex1 [--direct-io] [--stats] [--workers N | --index N | --merge-into <sorted_csv> | --pipeline | --project] <input_csv[.gz]> <output_csv[.gz]> <field> <algo>\n"
+                        "       bin/main_ex1 [--direct-io] [--stats] --batch <input_csv[.gz]> <algo> <field>:<output_csv> [<field>:<output_csv> ...]";
+    size_t workers = 0;
+    size_t stride = 0;
+    const char *merge_into = NULL;
+    int batch = 0;
+    int pipeline = 0;
+    int project = 0;
+    int stats = 0;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "w:bi:m:pdks", options, NULL)) != -1) {
+        switch (opt) {
+            case 'b':
+                batch = 1;
+                break;
+            case 'd':
+                io_backend_set_direct(1);
+                break;
+            case 'k':
+                project = 1;
+                break;
+            case 's':
+                stats = 1;
+                stats_enable();
+                break;
+            case 'p':
+                pipeline = 1;
+                break;
+            case 'm':
+                merge_into = optarg;
+                break;
+            case 'i':
+                stride = (size_t)atoi(optarg);
+                if (stride == 0)
+                    GENERIC_ERROR("Error: --index expects a positive number of lines");
+                break;
+            case 'w':
+                workers = (size_t)atoi(optarg);
+                if (workers == 0)
+                    GENERIC_ERROR("Error: --workers expects a positive number");
+                break;
+            default:
+                GENERIC_ERROR(usage);
+        }
+    }
+
+    if (batch) {
+        run_batch(argc - optind, argv + optind);
+        if (stats)
+            stats_print_json(stderr);
+        return 0;
+    }
+
+    if(argc - optind != 4) 
+        GENERIC_ERROR(usage);
+    argv += optind;
+
+    if (merge_into && strcmp(merge_into, argv[1]) == 0)
+        GENERIC_ERROR("Error: the merged output must differ from the sorted file");
+
+    size_t field = (size_t)atoi(argv[2]);
+    size_t algo = parse_algo(argv[3]);
 
-    FILE *infile = fopen(argv[1], "r");
+    if ((workers > 0) + (stride > 0) + (merge_into != NULL) + pipeline + project > 1)
+        GENERIC_ERROR("Error: --workers, --index, --merge-into, --pipeline and --project cannot be combined");
+
+    size_t output_len = strlen(argv[1]);
+    int compress = output_len > 3 && strcmp(argv[1] + output_len - 3, ".gz") == 0;
+    if (compress && (workers > 0 || stride > 0 || merge_into || pipeline || project))
+        GENERIC_ERROR("Error: a .gz output can only be written without --workers, --index, --merge-into, --pipeline and --project");
+
+    FILE *infile = fopen(argv[0], "r");
     if(!infile)
         GENERIC_ERROR("fopen: error opening input file");
-    FILE *outfile = fopen(argv[2], "w+");
+
+    // workers split the input by byte ranges, the pipeline reads it with fgets and
+    // the projection maps it in memory
+    if ((workers > 0 || pipeline || project) && gzip_detect(infile))
+        GENERIC_ERROR("Error: --workers, --pipeline and --project need an uncompressed input");
+
+    FILE *sorted = NULL;
+    if (merge_into) {
+        sorted = fopen(merge_into, "r");
+        if (!sorted)
+            GENERIC_ERROR("fopen: error opening sorted file");
+    }
+
+    // opening the output truncates it, so only once everything else checks out
+    FILE *outfile = fopen(argv[1], "w+");
     if(!outfile)
         GENERIC_ERROR("fopen: error opening output file");
 
-    size_t field = (size_t)atoi(argv[3]);
-    size_t algo = (size_t)atoi(argv[4]);
+    if (workers > 0) {
+        fclose(infile);
+        distributed_sort(argv[0], outfile, field, algo, workers);
+        fclose(outfile);
+        // the workers are separate processes: only the peak RSS of the largest one is reported
+        if (stats)
+            stats_print_json(stderr);
+        return 0;
+    }
     
-    sort_records(infile, outfile, field, algo);
+    if (merge_into) {
+        merge_records_into(sorted, infile, outfile, field, algo);
+        fclose(sorted);
+    } else if (project) {
+        sort_records_projected(infile, outfile, field, algo);
+    } else if (pipeline) {
+        pipeline_sort(infile, outfile, field, algo);
+    } else if (stride > 0) {
+        char *index_path = malloc(strlen(argv[1]) + sizeof(".idx"));
+        if (!index_path)
+            GENERIC_ERROR("malloc: memory allocation failed");
+
+        sprintf(index_path, "%s.idx", argv[1]);
+        sort_records_indexed(infile, outfile, field, algo, stride, index_path);
+        free(index_path);
+    } else if (compress) {
+        sort_records_compressed(infile, outfile, field, algo);
+    } else {
+        sort_records(infile, outfile, field, algo);
+    }
 
 
     fclose(infile);
     fclose(outfile);
+
+    if (stats)
+        stats_print_json(stderr);
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "../include/utils.h"
+
+/**
+ * @brief Sorts a delta of new records and merges it into an already sorted file.
+ * 
+ * Only the delta is loaded and sorted; the existing sorted file is then streamed line
+ * by line and merged with it in a single sequential pass, so the cost is the sort of the
+ * delta plus one linear pass instead of a full sort. Existing lines are copied verbatim
+ * and come before delta records with an equal key, which keeps the merge stable. Both go
+ * through a single RecordWriter, each run of delta records in one batch.
+ * 
+ * @param sorted Pointer to the file already sorted by field (must differ from outfile).
+ * @param delta Pointer to the file containing the new records.
+ * @param outfile Pointer to the output file where the merged records will be saved.
+ * @param field The field number both files are sorted by (1: string, 2: integer, 3: float).
+ * @param algo The sorting algorithm used on the delta (see sort_records).
+ */
+void merge_records_into(FILE *sorted, FILE *delta, FILE *outfile, size_t field, size_t algo) {
+    if (!sorted || !delta || !outfile)
+        GENERIC_ERROR("merge_records_into: file not provided");
+
+    int (*compar)(const void *, const void *) = record_comparator(field);
+
+    size_t lines;
+    Record *records = read_records(delta, &lines);
+    sort_record_array(records, lines, field, algo);
+
+    RecordWriter *writer = record_writer_open(outfile);
+    char buffer[BUFSIZ];
+    char scratch[BUFSIZ];
+    size_t next = 0;
+
+    while (fgets(buffer, sizeof(buffer), sorted)) {
+        size_t len = strlen(buffer);
+
+        // once the delta is exhausted, the remaining lines are copied without parsing
+        if (next < lines) {
+            Record existing;
+
+            memcpy(scratch, buffer, len + 1);
+            parse_record(scratch, &existing);
+
+            size_t first = next;
+            while (next < lines && compar(&records[next], &existing) < 0)
+                next++;
+            record_writer_save(writer, records + first, next - first);
+
+            free(existing.field_str);
+        }
+
+        record_writer_copy(writer, buffer, len);
+    }
+
+    record_writer_save(writer, records + next, lines - next);
+    record_writer_close(writer);
+
+    for (size_t i = 0; i < lines; i++)
+        free(records[i].field_str);
+    free(records);
+}
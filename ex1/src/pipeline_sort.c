@@ -0,0 +1,339 @@
+#include "../include/utils.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// records parsed into one run before it is handed to the sorters
+#define PIPELINE_RUN_LINES 65536
+// size of each of the two output buffers
+#define PIPELINE_WRITE_BYTES (1 << 20)
+
+/**
+ * Runs produced by the reader and sorted in place by the sorter threads.
+ * Runs keep the order of the input, which the final merge relies on for stability.
+ */
+typedef struct {
+    Record **runs;
+    size_t *lengths;
+    size_t count;
+    size_t cap;
+    size_t next;        // first run not yet taken by a sorter
+    int done;           // the reader reached the end of the input
+    size_t field;
+    size_t algo;        // resolved on the first run when 0, before any sorter reads it
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+} RunQueue;
+
+/**
+ * Double-buffered output: the merge fills one buffer while the writer thread
+ * drains the other one to the output file.
+ */
+typedef struct {
+    FILE *outfile;
+    char *data[2];
+    size_t used[2];
+    size_t cap[2];
+    int full[2];
+    int finished;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} WriteBuffers;
+
+/**
+ * Head of a run in the merge heap.
+ */
+typedef struct {
+    Record *records;
+    size_t pos;
+    size_t len;
+    size_t run;
+} RunHead;
+
+static void *sorter_thread(void *arg) {
+    RunQueue *queue = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        while (queue->next == queue->count && !queue->done)
+            pthread_cond_wait(&queue->ready, &queue->lock);
+
+        if (queue->next == queue->count) {
+            pthread_mutex_unlock(&queue->lock);
+            return NULL;
+        }
+
+        Record *run = queue->runs[queue->next];
+        size_t len = queue->lengths[queue->next];
+        size_t algo = queue->algo;
+        queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+
+        sort_record_array(run, len, queue->field, algo);
+    }
+}
+
+static void push_run(RunQueue *queue, Record *run, size_t len) {
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->count == queue->cap) {
+        queue->cap = queue->cap ? queue->cap * 2 : 16;
+        queue->runs = realloc(queue->runs, queue->cap * sizeof(Record *));
+        queue->lengths = realloc(queue->lengths, queue->cap * sizeof(size_t));
+        if (!queue->runs || !queue->lengths)
+            GENERIC_ERROR("realloc: memory allocation failed");
+    }
+
+    queue->runs[queue->count] = run;
+    queue->lengths[queue->count] = len;
+    queue->count++;
+
+    pthread_cond_signal(&queue->ready);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/**
+ * @brief Parses the input into runs of PIPELINE_RUN_LINES records and queues each one
+ * as soon as it is complete, so that sorting starts while the rest is still being read.
+ * With algo=0 the algorithm is chosen once, on the first run, for all of them.
+ */
+static void read_runs(FILE *infile, RunQueue *queue) {
+    char buffer[BUFSIZ];
+    Record *run = NULL;
+    size_t len = 0;
+
+    while (fgets(buffer, sizeof(buffer), infile)) {
+        if (!run) {
+            run = malloc(PIPELINE_RUN_LINES * sizeof(Record));
+            if (!run)
+                GENERIC_ERROR("malloc: memory allocation failed");
+        }
+
+        parse_record(buffer, &run[len++]);
+
+        if (len == PIPELINE_RUN_LINES) {
+            if (queue->count == 0)
+                queue->algo = resolve_algorithm(run, len, queue->field, queue->algo);
+            push_run(queue, run, len);
+            run = NULL;
+            len = 0;
+        }
+    }
+
+    if (run) {
+        if (queue->count == 0)
+            queue->algo = resolve_algorithm(run, len, queue->field, queue->algo);
+        push_run(queue, run, len);
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    queue->done = 1;
+    pthread_cond_broadcast(&queue->ready);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static void *writer_thread(void *arg) {
+    WriteBuffers *out = arg;
+    size_t current = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&out->lock);
+        while (!out->full[current] && !out->finished)
+            pthread_cond_wait(&out->changed, &out->lock);
+
+        if (!out->full[current]) {
+            pthread_mutex_unlock(&out->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&out->lock);
+
+        if (fwrite(out->data[current], 1, out->used[current], out->outfile) != out->used[current])
+            GENERIC_ERROR("fwrite: error writing to output file");
+
+        pthread_mutex_lock(&out->lock);
+        out->full[current] = 0;
+        pthread_cond_broadcast(&out->changed);
+        pthread_mutex_unlock(&out->lock);
+
+        current ^= 1;
+    }
+}
+
+/**
+ * @brief Hands the current buffer to the writer and waits until the other one is free.
+ *
+ * @return The index of the buffer to fill next.
+ */
+static size_t flush_buffer(WriteBuffers *out, size_t current) {
+    pthread_mutex_lock(&out->lock);
+    out->full[current] = 1;
+    pthread_cond_broadcast(&out->changed);
+
+    current ^= 1;
+    while (out->full[current])
+        pthread_cond_wait(&out->changed, &out->lock);
+    pthread_mutex_unlock(&out->lock);
+
+    out->used[current] = 0;
+    return current;
+}
+
+// formats a record with format_record(), the formatter of the other save paths
+static size_t append_record(WriteBuffers *out, size_t current, const Record *record) {
+    size_t need = strlen(record->field_str) + FORMAT_LINE_SLACK;
+
+    if (out->cap[current] - out->used[current] < need) {
+        if (out->used[current] > 0)
+            current = flush_buffer(out, current);
+
+        if (out->cap[current] < need) {
+            out->cap[current] = need;
+            out->data[current] = realloc(out->data[current], out->cap[current]);
+            if (!out->data[current])
+                GENERIC_ERROR("realloc: memory allocation failed");
+        }
+    }
+
+    char *data = out->data[current];
+    out->used[current] = format_record(data + out->used[current], record) - data;
+    return current;
+}
+
+// ties go to the earlier run, which keeps the merge stable
+static int head_less(const RunHead *a, const RunHead *b, int (*compar)(const void *, const void *)) {
+    int cmp = compar(&a->records[a->pos], &b->records[b->pos]);
+
+    return cmp < 0 || (cmp == 0 && a->run < b->run);
+}
+
+static void sift_down(RunHead *heap, size_t count, size_t i, int (*compar)(const void *, const void *)) {
+    for (;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+
+        if (left < count && head_less(&heap[left], &heap[smallest], compar))
+            smallest = left;
+        if (right < count && head_less(&heap[right], &heap[smallest], compar))
+            smallest = right;
+        if (smallest == i)
+            return;
+
+        RunHead temp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = temp;
+        i = smallest;
+    }
+}
+
+/**
+ * @brief Merges the sorted runs straight into the output buffers.
+ */
+static void merge_runs(RunQueue *queue, WriteBuffers *out, int (*compar)(const void *, const void *)) {
+    RunHead *heap = malloc((queue->count ? queue->count : 1) * sizeof(RunHead));
+    if (!heap)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    size_t count = queue->count;
+    for (size_t r = 0; r < count; r++)
+        heap[r] = (RunHead){ queue->runs[r], 0, queue->lengths[r], r };
+    for (size_t i = count / 2; i-- > 0; )
+        sift_down(heap, count, i, compar);
+
+    size_t current = 0;
+    while (count > 0) {
+        current = append_record(out, current, &heap[0].records[heap[0].pos]);
+
+        if (++heap[0].pos == heap[0].len)
+            heap[0] = heap[--count];
+        sift_down(heap, count, 0, compar);
+    }
+
+    pthread_mutex_lock(&out->lock);
+    if (out->used[current] > 0)
+        out->full[current] = 1;
+    out->finished = 1;
+    pthread_cond_broadcast(&out->changed);
+    pthread_mutex_unlock(&out->lock);
+
+    free(heap);
+}
+
+/**
+ * @brief Sorts records like sort_records(), overlapping loading, sorting and saving.
+ *
+ * The calling thread reads and parses the input in runs; sorter threads (one per
+ * online core) sort each run as soon as it is complete, while the next one is being
+ * read. The sorted runs are then merged with a heap, ties going to the earlier run,
+ * and formatted into one of two buffers while a writer thread saves the other one.
+ * With a stable algorithm the output is identical to the one of sort_records().
+ *
+ * @param infile Pointer to the input file containing records to be sorted.
+ * @param outfile Pointer to the output file where sorted records will be saved.
+ * @param field The field number to sort by (1: string, 2: integer, 3: float).
+ * @param algo The sorting algorithm used on each run (see sort_records).
+ */
+void pipeline_sort(FILE *infile, FILE *outfile, size_t field, size_t algo) {
+    if (!infile || !outfile)
+        GENERIC_ERROR("pipeline_sort: file not provided");
+
+    int (*compar)(const void *, const void *) = record_comparator(field);
+
+    RunQueue queue = { .field = field, .algo = algo };
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.ready, NULL);
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t nsorters = cores > 0 ? (size_t)cores : 1;
+
+    pthread_t *sorters = malloc(nsorters * sizeof(pthread_t));
+    if (!sorters)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t t = 0; t < nsorters; t++) {
+        if (pthread_create(&sorters[t], NULL, sorter_thread, &queue) != 0)
+            GENERIC_ERROR("pthread_create: error starting a sorter thread");
+    }
+
+    // loading overlaps with the sorters, whose time is counted in the sort phase
+    StatsClock clock = stats_phase_begin();
+    read_runs(infile, &queue);
+    stats_phase_end(STATS_PHASE_LOAD, clock);
+
+    for (size_t t = 0; t < nsorters; t++)
+        pthread_join(sorters[t], NULL);
+
+    clock = stats_phase_begin();
+    WriteBuffers out = { .outfile = outfile };
+    for (size_t b = 0; b < 2; b++) {
+        out.cap[b] = PIPELINE_WRITE_BYTES;
+        out.data[b] = malloc(out.cap[b]);
+        if (!out.data[b])
+            GENERIC_ERROR("malloc: memory allocation failed");
+    }
+    pthread_mutex_init(&out.lock, NULL);
+    pthread_cond_init(&out.changed, NULL);
+
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, writer_thread, &out) != 0)
+        GENERIC_ERROR("pthread_create: error starting the writer thread");
+
+    merge_runs(&queue, &out, compar);
+    pthread_join(writer, NULL);
+    stats_phase_end(STATS_PHASE_SAVE, clock);
+
+    for (size_t r = 0; r < queue.count; r++) {
+        for (size_t i = 0; i < queue.lengths[r]; i++)
+            free(queue.runs[r][i].field_str);
+        free(queue.runs[r]);
+    }
+    free(queue.runs);
+    free(queue.lengths);
+    free(out.data[0]);
+    free(out.data[1]);
+    free(sorters);
+
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.ready);
+    pthread_mutex_destroy(&out.lock);
+    pthread_cond_destroy(&out.changed);
+}
@@ -0,0 +1,189 @@
+#include "../include/utils.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Sort key of one input line and where the line is: only the selected column is
+ * parsed, the line itself is copied verbatim from the input when saving.
+ */
+typedef struct {
+    union {
+        int i;
+        double d;
+        uint64_t str;   // offset of the string field in the input
+    } key;
+    uint32_t key_len;   // length of the string field (field 1 only)
+    uint32_t length;    // length of the line, newline excluded
+    uint64_t offset;
+} ProjectedRecord;
+
+// input mapping used by compare_projected_str, set for the duration of the sort
+static const char *projected_input;
+
+static int compare_projected_str(const void *a, const void *b) {
+    ARGUMENTS_ERROR(a, b);
+
+    const ProjectedRecord *x = a;
+    const ProjectedRecord *y = b;
+    uint32_t len = x->key_len < y->key_len ? x->key_len : y->key_len;
+    int cmp = memcmp(projected_input + x->key.str, projected_input + y->key.str, len);
+
+    return cmp != 0 ? cmp : (x->key_len > y->key_len) - (x->key_len < y->key_len);
+}
+
+static int compare_projected_int(const void *a, const void *b) {
+    ARGUMENTS_ERROR(a, b);
+
+    const ProjectedRecord *x = a;
+    const ProjectedRecord *y = b;
+
+    return (x->key.i > y->key.i) - (x->key.i < y->key.i);
+}
+
+static int compare_projected_float(const void *a, const void *b) {
+    ARGUMENTS_ERROR(a, b);
+
+    const ProjectedRecord *x = a;
+    const ProjectedRecord *y = b;
+
+    return (x->key.d > y->key.d) - (x->key.d < y->key.d);
+}
+
+/**
+ * @brief Parses the selected column of a line, the same way parse_record() would.
+ *
+ * @return 0 on success, -1 if the line has fewer columns than needed.
+ */
+static int project_line(const char *input, const char *line, const char *end, size_t field, ProjectedRecord *record) {
+    const char *column = line;
+
+    for (size_t f = 0; f < field; f++) {
+        column = memchr(column, ',', end - column);
+        if (!column)
+            return -1;
+        column++;
+    }
+
+    switch (field) {
+        case 1: {
+            const char *comma = memchr(column, ',', end - column);
+            if (!comma)
+                return -1;
+
+            record->key.str = (uint64_t)(column - input);
+            record->key_len = (uint32_t)(comma - column);
+            break;
+        }
+        case 2:
+            record->key.i = atoi(column);
+            break;
+        default:
+            record->key.d = atof(column);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Sorts the lines of a file by one field without loading the other columns.
+ *
+ * The input is mapped in memory and scanned once: each line contributes its key, parsed
+ * from the selected column only, plus its offset and length. These projected records
+ * are sorted with the requested algorithm and the lines are then copied verbatim from
+ * the mapping to the output, so no string is duplicated and no other field is parsed.
+ * Since lines are not reformatted, the output matches sort_records() only when the
+ * input is already written in the "%d,%s,%d,%f" format.
+ *
+ * @param infile Pointer to the input file containing records to be sorted (regular, uncompressed).
+ * @param outfile Pointer to the output file where the sorted lines will be saved.
+ * @param field The field number to sort by (1: string, 2: integer, 3: float).
+ * @param algo The sorting algorithm to use (see sort_records).
+ */
+void sort_records_projected(FILE *infile, FILE *outfile, size_t field, size_t algo) {
+    if (!infile || !outfile)
+        GENERIC_ERROR("sort_records_projected: file not provided");
+
+    int (*compar)(const void *, const void *);
+    switch (field) {
+        case 1:
+            compar = compare_projected_str;
+            break;
+        case 2:
+            compar = compare_projected_int;
+            break;
+        case 3:
+            compar = compare_projected_float;
+            break;
+        default:
+            GENERIC_ERROR("Error: invalid field number");
+    }
+
+    StatsClock clock = stats_phase_begin();
+    struct stat st;
+    if (fstat(fileno(infile), &st) != 0 || !S_ISREG(st.st_mode))
+        GENERIC_ERROR("sort_records_projected: the input must be a regular file");
+
+    size_t size = (size_t)st.st_size;
+    const char *input = NULL;
+    if (size > 0) {
+        input = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(infile), 0);
+        if (input == MAP_FAILED)
+            GENERIC_ERROR("mmap: error mapping input file");
+        madvise((void *)input, size, MADV_SEQUENTIAL);
+    }
+
+    size_t cap = 1024;
+    size_t lines = 0;
+    ProjectedRecord *records = malloc(cap * sizeof(ProjectedRecord));
+    if (!records)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (const char *line = input, *end = input + size; line < end; ) {
+        const char *newline = memchr(line, '\n', end - line);
+        const char *line_end = newline ? newline : end;
+
+        if (lines == cap) {
+            cap *= 2;
+            records = realloc(records, cap * sizeof(ProjectedRecord));
+            if (!records)
+                GENERIC_ERROR("realloc: memory allocation failed");
+        }
+
+        ProjectedRecord *record = &records[lines++];
+        if (project_line(input, line, line_end, field, record) != 0)
+            GENERIC_ERROR("sort_records_projected: malformed line");
+        record->offset = (uint64_t)(line - input);
+        record->length = (uint32_t)(line_end - line);
+
+        line = line_end + 1;
+    }
+    stats_phase_end(STATS_PHASE_LOAD, clock);
+
+    projected_input = input;
+    sort_with_algorithm(records, lines, sizeof(ProjectedRecord), field, compar, algo);
+    projected_input = NULL;
+
+    if (size > 0)
+        madvise((void *)input, size, MADV_RANDOM);
+
+    clock = stats_phase_begin();
+    IoFile *io = io_writer_open(outfile);
+    for (size_t i = 0; i < lines; i++) {
+        const char *line = input + records[i].offset;
+
+        // the last line may lack its newline; the copy always gets one
+        if (io) {
+            io_writer_write(io, line, records[i].length);
+            io_writer_write(io, "\n", 1);
+        } else if (fwrite(line, 1, records[i].length, outfile) != records[i].length || fputc('\n', outfile) == EOF) {
+            GENERIC_ERROR("fwrite: error writing to output file");
+        }
+    }
+    if (io)
+        io_writer_close(io);
+    stats_phase_end(STATS_PHASE_SAVE, clock);
+
+    if (size > 0)
+        munmap((void *)input, size);
+    free(records);
+}
@@ -0,0 +1,72 @@
+#include "../include/utils.h"
+#include <time.h>
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/**
+ * @brief Prints the lines of a sorted file whose key lies between low and high, inclusive.
+ * 
+ * The sparse index gives the position of the last sampled line before low; the file is
+ * read from there, lines below low are skipped and the scan stops at the first line
+ * above high, so at most one stride of lines is read besides the matching ones.
+ * The time spent in the index lookup is reported on stderr.
+ * 
+ * @param sorted Pointer to the sorted CSV file.
+ * @param index Pointer to the index of that file.
+ * @param low The lower bound of the range, as text.
+ * @param high The upper bound of the range, as text.
+ */
+static void query_range(FILE *sorted, SparseIndex *index, const char *low, const char *high) {
+    SparseIndexKey low_key = sparse_index_parse_key(index, low);
+    SparseIndexKey high_key = sparse_index_parse_key(index, high);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t offset = sparse_index_seek(index, &low_key);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (fseeko(sorted, (off_t)offset, SEEK_SET) != 0)
+        GENERIC_ERROR("fseeko: error seeking sorted file");
+
+    size_t scanned = 0, matched = 0;
+    char buffer[BUFSIZ];
+
+    while (fgets(buffer, sizeof(buffer), sorted)) {
+        scanned++;
+
+        if (sparse_index_compare_line(index, buffer, &low_key) < 0)
+            continue;
+        if (sparse_index_compare_line(index, buffer, &high_key) > 0)
+            break;
+
+        matched++;
+        fputs(buffer, stdout);
+    }
+
+    fprintf(stderr, "lookup: %.2f us, offset %llu, %zu lines read, %zu matched\n",
+            elapsed_us(&start, &end), (unsigned long long)offset, scanned, matched);
+}
+
+int main(int argc, char *argv[]) {
+    if(argc != 4)
+        GENERIC_ERROR("Usage: bin/query_ex1 <sorted_csv> <low> <high>");
+
+    FILE *sorted = fopen(argv[1], "r");
+    if(!sorted)
+        GENERIC_ERROR("fopen: error opening sorted file");
+
+    char *index_path = malloc(strlen(argv[1]) + sizeof(".idx"));
+    if (!index_path)
+        GENERIC_ERROR("malloc: memory allocation failed");
+    sprintf(index_path, "%s.idx", argv[1]);
+
+    SparseIndex *index = sparse_index_read(index_path);
+
+    query_range(sorted, index, argv[2], argv[3]);
+
+    sparse_index_free(index);
+    free(index_path);
+    fclose(sorted);
+}
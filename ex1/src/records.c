@@ -0,0 +1,819 @@
+#include "../include/utils.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// algo=0 thresholds: above AUTO_PRESORTED_RATIO of ordered neighbour pairs going the same
+// way, or below AUTO_DISTINCT_RATIO of distinct sampled keys, quick_sort degenerates
+#define AUTO_PRESORTED_RATIO 0.9
+#define AUTO_DISTINCT_RATIO 0.9
+
+// records formatted by one thread before the text is written
+#define SAVE_SLICE_LINES 65536
+// doubles at or above this magnitude (10^19 millionths, near 2^64) are formatted by snprintf
+#define FORMAT_FIXED_LIMIT 1e13
+
+/**
+ * Destination of the formatted lines: the I/O backend, a gzip stream, or plain stdio.
+ */
+typedef struct {
+    IoFile *io;
+    GzipStream *gz;
+    FILE *file;
+} LineSink;
+
+/**
+ * Slice of the records formatted by one thread into its own buffer.
+ */
+typedef struct {
+    const Record *records;
+    size_t first;
+    size_t count;
+    size_t stride;
+    uint64_t *offsets;
+    char *data;
+    size_t len;
+    size_t cap;
+} FormatSlice;
+
+static int compare_field_int(const void *a, const void *b) {
+    ARGUMENTS_ERROR(a, b);
+
+    Record *x = (Record *)a;
+    Record *y = (Record *)b;
+
+    return x->field_int - y->field_int;
+}
+
+static int compare_field_str(const void *a, const void *b) {
+    ARGUMENTS_ERROR(a, b);
+
+    Record *x = (Record *)a;
+    Record *y = (Record *)b;
+
+    return strcmp(x->field_str, y->field_str);
+}
+
+static int compare_field_float(const void *a, const void *b) {
+    ARGUMENTS_ERROR(a, b);
+
+    Record *x = (Record *)a;
+    Record *y = (Record *)b;
+
+    return (x->field_fp > y->field_fp) - (x->field_fp < y->field_fp);
+}
+
+/**
+ * @brief Returns the comparison function that orders records by the given field.
+ * 
+ * @param field The field number to sort by (1: string, 2: integer, 3: float).
+ * @return Pointer to the comparison function for that field.
+ */
+int (*record_comparator(size_t field))(const void *, const void *) {
+    switch (field) {
+        case 1:
+            return compare_field_str;
+        case 2:
+            return compare_field_int;
+        case 3:
+            return compare_field_float;
+        default:
+            GENERIC_ERROR("Error: invalid field number");
+    }
+}
+
+/**
+ * @brief Parses one CSV line into a record.
+ * 
+ * The line is tokenized in place; the string field is duplicated, so the line can be
+ * reused once the function returns.
+ * 
+ * @param line The line to parse, in the "id,field_str,field_int,field_fp" format.
+ * @param record Pointer to the record to fill.
+ */
+void parse_record(char *line, Record *record) {
+    Record temp_record = {
+        atoi(strtok(line, ",")),
+        strdup(strtok(NULL, ",")),
+        atoi(strtok(NULL, ",")),
+        atof(strtok(NULL, ","))
+    };
+    *record = temp_record;
+    STATS_ALLOC();
+}
+
+/**
+ * @brief Counts the number of lines in a given file.
+ * 
+ * This function reads the given file line by line and counts the total number of lines.
+ * It then resets the file position to the beginning of the file.
+ * Regular files are read in large chunks through the I/O backend (see io_backend.c).
+ * 
+ * @param infile Pointer to the file to be read.
+ * @return The number of lines in the file.
+ */
+size_t count_lines(FILE *infile) {
+    if (!infile) 
+        GENERIC_ERROR("count_lines: infile not provided");
+    
+    StatsClock clock = stats_phase_begin();
+    size_t count = 0; 
+    IoFile *io = io_reader_open(infile);
+
+    if (io) {
+        char *chunk;
+        size_t len;
+        char last = '\n';
+
+        while ((chunk = io_reader_next(io, &len))) {
+            for (char *p = chunk, *end = chunk + len; (p = memchr(p, '\n', end - p)); p++)
+                count++;
+            last = chunk[len - 1];
+        }
+        // a last line without a newline still counts
+        if (last != '\n')
+            count++;
+
+        io_reader_close(io, 0);
+    } else {
+        char buffer[BUFSIZ];
+
+        while(fgets(buffer, sizeof(buffer), infile))
+            count++;
+    }
+
+    if (fseek(infile, 0, SEEK_SET) != 0)
+        GENERIC_ERROR("fseek: Error resetting file");
+
+    stats_phase_end(STATS_PHASE_COUNT, clock);
+    return count;
+}
+
+/**
+ * Line cut by the end of a chunk, completed by the beginning of the next one.
+ */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} LineCarry;
+
+static void carry_append(LineCarry *carry, const char *data, size_t n) {
+    if (carry->len + n + 1 > carry->cap) {
+        carry->cap = (carry->len + n + 1) * 2;
+        carry->data = realloc(carry->data, carry->cap);
+        if (!carry->data)
+            GENERIC_ERROR("realloc: memory allocation failed");
+    }
+
+    memcpy(carry->data + carry->len, data, n);
+    carry->len += n;
+    carry->data[carry->len] = '\0';
+}
+
+/**
+ * @brief Returns the next complete line of a chunk, NUL-terminated in place.
+ * 
+ * Only a line straddling two chunks is copied, into carry; the bytes left at the end
+ * of the chunk are kept there until the next chunk completes them.
+ * 
+ * @param p Pointer to the current position in the chunk, moved past the line.
+ * @param end The end of the chunk.
+ * @param carry The line cut by the end of the previous chunk.
+ * @param len Pointer to the length of the line in the file, newline included.
+ * @return Pointer to the line, or NULL once the chunk is exhausted.
+ */
+static char *next_line(char **p, char *end, LineCarry *carry, size_t *len) {
+    char *line = *p;
+    char *newline = memchr(line, '\n', end - line);
+
+    if (!newline) {
+        carry_append(carry, line, end - line);
+        *p = end;
+        return NULL;
+    }
+
+    *newline = '\0';
+    *len = newline - line + 1;
+    *p = newline + 1;
+
+    if (carry->len > 0) {
+        *len += carry->len;
+        carry_append(carry, line, newline - line);
+        carry->len = 0;
+        line = carry->data;
+    }
+
+    return line;
+}
+
+/**
+ * @brief Loads records from a given file.
+ * 
+ * This function reads the specified number of lines from the file and parses each line
+ * into a Record structure. The records are stored in an array which is returned.
+ * Regular files are read in large chunks through the I/O backend and parsed in place;
+ * only lines straddling two chunks are copied.
+ * 
+ * @param infile Pointer to the file to be read.
+ * @param lines The number of lines to read from the file.
+ * @return Pointer to an array of records.
+ */
+Record *load_records(FILE *infile, size_t lines) {
+    if (!infile) 
+        GENERIC_ERROR("load_records: file not provided");
+    
+    StatsClock clock = stats_phase_begin();
+    Record *records = malloc(lines * sizeof(Record));
+    if (!records) 
+        GENERIC_ERROR("malloc: memory allocation failed");
+    STATS_ALLOC();
+    
+    IoFile *io = io_reader_open(infile);
+    if (!io) {
+        char buffer[BUFSIZ];
+        for(size_t i = 0; fgets(buffer, sizeof(buffer), infile) && i < lines; i++) {
+            parse_record(buffer, &records[i]);
+        }
+
+        stats_flush();
+        stats_phase_end(STATS_PHASE_LOAD, clock);
+        return records;
+    }
+
+    LineCarry carry = {0};
+    uint64_t consumed = 0;
+    size_t i = 0;
+    char *chunk;
+    size_t len;
+
+    while (i < lines && (chunk = io_reader_next(io, &len))) {
+        char *p = chunk;
+        char *line;
+        size_t line_len;
+
+        while (i < lines && (line = next_line(&p, chunk + len, &carry, &line_len))) {
+            parse_record(line, &records[i++]);
+            consumed += line_len;
+        }
+    }
+
+    if (i < lines && carry.len > 0) {
+        parse_record(carry.data, &records[i]);
+        consumed += carry.len;
+    }
+
+    io_reader_close(io, consumed);
+    free(carry.data);
+
+    stats_flush();
+    stats_phase_end(STATS_PHASE_LOAD, clock);
+    return records;
+}
+
+// parses a line at the end of a growable array of records
+static void push_record(Record **records, size_t *count, size_t *cap, char *line) {
+    if (*count == *cap) {
+        *cap *= 2;
+        *records = realloc(*records, *cap * sizeof(Record));
+        if (!*records)
+            GENERIC_ERROR("realloc: memory allocation failed");
+        STATS_ALLOC();
+    }
+
+    parse_record(line, &(*records)[(*count)++]);
+}
+
+/**
+ * @brief Loads all the records of a file, plain or gzip-compressed.
+ * 
+ * Plain files are counted and loaded with count_lines() and load_records(). Gzip files
+ * are inflated once, on a separate thread (see gzip_stream.c), while this thread parses
+ * the decompressed blocks, growing the array as it goes.
+ * 
+ * @param infile Pointer to the file to be read.
+ * @param lines Pointer to the number of records read.
+ * @return Pointer to an array of records.
+ */
+Record *read_records(FILE *infile, size_t *lines) {
+    if (!infile || !lines)
+        GENERIC_ERROR("read_records: file not provided");
+
+    if (!gzip_detect(infile)) {
+        *lines = count_lines(infile);
+        return load_records(infile, *lines);
+    }
+
+    StatsClock clock = stats_phase_begin();
+    size_t cap = 1024;
+    size_t count = 0;
+    Record *records = malloc(cap * sizeof(Record));
+    if (!records)
+        GENERIC_ERROR("malloc: memory allocation failed");
+    STATS_ALLOC();
+
+    GzipStream *gz = gzip_reader_open(infile);
+    LineCarry carry = {0};
+    char *block;
+    size_t len;
+
+    while ((block = gzip_reader_next(gz, &len))) {
+        char *p = block;
+        char *line;
+        size_t line_len;
+
+        while ((line = next_line(&p, block + len, &carry, &line_len)))
+            push_record(&records, &count, &cap, line);
+    }
+    if (carry.len > 0)
+        push_record(&records, &count, &cap, carry.data);
+
+    gzip_reader_close(gz);
+    free(carry.data);
+
+    stats_flush();
+    stats_phase_end(STATS_PHASE_LOAD, clock);
+    *lines = count;
+    return records;
+}
+
+// writes the decimal digits of value and returns the end of the text
+static char *format_uint(char *out, uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (n > 0)
+        *out++ = digits[--n];
+
+    return out;
+}
+
+static char *format_int(char *out, int value) {
+    if (value < 0) {
+        *out++ = '-';
+        return format_uint(out, -(uint64_t)value);
+    }
+
+    return format_uint(out, (uint64_t)value);
+}
+
+/**
+ * @brief Writes a double exactly as printf("%f") does and returns the end of the text.
+ * 
+ * A finite double is m * 2^-shift for a 53-bit integer m, so the value scaled by 10^6 is
+ * m * 10^6 / 2^shift, computed exactly in 128 bits and rounded half to even like glibc.
+ * Magnitudes of FORMAT_FIXED_LIMIT and more, infinities and NaNs go through snprintf.
+ */
+static char *format_fixed(char *out, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    int negative = (int)(bits >> 63);
+    int exponent = (int)((bits >> 52) & 0x7ff);
+    uint64_t mantissa = bits & ((1ULL << 52) - 1);
+
+    if (exponent == 0x7ff || (negative ? -value : value) >= FORMAT_FIXED_LIMIT) {
+        char text[FORMAT_LINE_SLACK];
+        int len = snprintf(text, sizeof(text), "%f", value);
+
+        memcpy(out, text, len);
+        return out + len;
+    }
+
+    if (exponent == 0)
+        exponent = 1;
+    else
+        mantissa |= 1ULL << 52;
+
+    // below the limit, the value always has a fractional part in binary: shift > 0
+    int shift = 1075 - exponent;
+    unsigned __int128 scaled = (unsigned __int128)mantissa * 1000000;
+    uint64_t micros = 0;
+
+    // with shift >= 128 the value is below half a millionth and rounds to zero
+    if (shift < 128) {
+        unsigned __int128 quotient = scaled >> shift;
+        unsigned __int128 rest = scaled - (quotient << shift);
+        unsigned __int128 half = (unsigned __int128)1 << (shift - 1);
+
+        if (rest > half || (rest == half && (quotient & 1)))
+            quotient++;
+        micros = (uint64_t)quotient;
+    }
+
+    if (negative)
+        *out++ = '-';
+    out = format_uint(out, micros / 1000000);
+    *out++ = '.';
+
+    uint64_t fraction = micros % 1000000;
+    for (int d = 5; d >= 0; d--) {
+        out[d] = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+
+    return out + 6;
+}
+
+/**
+ * @brief Writes a record as a "%d,%s,%d,%f\n" line and returns the end of the text.
+ * 
+ * The buffer must hold strlen(record->field_str) + FORMAT_LINE_SLACK bytes.
+ */
+char *format_record(char *out, const Record *record) {
+    size_t len = strlen(record->field_str);
+
+    out = format_int(out, record->id);
+    *out++ = ',';
+    memcpy(out, record->field_str, len);
+    out += len;
+    *out++ = ',';
+    out = format_int(out, record->field_int);
+    *out++ = ',';
+    out = format_fixed(out, record->field_fp);
+    *out++ = '\n';
+
+    return out;
+}
+
+static void sink_write(const LineSink *sink, const char *data, size_t len) {
+    if (sink->io)
+        io_writer_write(sink->io, data, len);
+    else if (sink->gz)
+        gzip_writer_write(sink->gz, data, len);
+    else if (fwrite(data, 1, len, sink->file) != len)
+        GENERIC_ERROR("fwrite: error writing to output file");
+}
+
+/**
+ * @brief Body of a formatting thread: formats one slice of the records into its buffer,
+ * noting the offsets of the sampled lines relative to the start of the slice.
+ */
+static void *format_slice(void *arg) {
+    FormatSlice *slice = arg;
+
+    slice->len = 0;
+    for (size_t i = slice->first; i < slice->first + slice->count; i++) {
+        const Record *record = &slice->records[i];
+        size_t need = strlen(record->field_str) + FORMAT_LINE_SLACK;
+
+        if (slice->len + need > slice->cap) {
+            slice->cap = slice->cap * 2 > slice->len + need ? slice->cap * 2 : slice->len + need;
+            slice->data = realloc(slice->data, slice->cap);
+            if (!slice->data)
+                GENERIC_ERROR("realloc: memory allocation failed");
+            STATS_ALLOC();
+        }
+
+        if (slice->stride && i % slice->stride == 0)
+            slice->offsets[i / slice->stride] = slice->len;
+
+        slice->len = format_record(slice->data + slice->len, record) - slice->data;
+    }
+
+    stats_flush();
+    return NULL;
+}
+
+// writes a formatted slice at position, turning its sampled offsets into file positions
+static uint64_t write_slice(const LineSink *sink, const FormatSlice *slice, uint64_t position) {
+    if (slice->stride) {
+        size_t last = slice->first + slice->count - 1;
+        for (size_t j = (slice->first + slice->stride - 1) / slice->stride; j <= last / slice->stride; j++)
+            slice->offsets[j] += position;
+    }
+
+    sink_write(sink, slice->data, slice->len);
+    return position + slice->len;
+}
+
+/**
+ * @brief Formats records in parallel and writes the text in order.
+ * 
+ * Each round hands one slice of SAVE_SLICE_LINES records to each thread (the calling
+ * thread takes the first one); the slice buffers are then written one after the other,
+ * so the output does not depend on the number of threads. Batches that fit in a single
+ * slice are formatted on the calling thread, without allocating the thread state.
+ * 
+ * @param sink The destination of the text.
+ * @param records Pointer to the array of records to be saved.
+ * @param lines The number of records to write.
+ * @param stride The sampling stride (0 to sample nothing).
+ * @param offsets The offsets of the sampled lines (NULL when stride is 0).
+ * @param start The position of the sink in the file, added to the offsets.
+ * @param threads The number of formatting threads.
+ */
+static void save_formatted(const LineSink *sink, const Record *records, size_t lines, size_t stride, uint64_t *offsets, uint64_t start, size_t threads) {
+    if (lines <= SAVE_SLICE_LINES) {
+        FormatSlice slice = { .records = records, .count = lines, .stride = stride, .offsets = offsets };
+
+        if (lines > 0) {
+            format_slice(&slice);
+            write_slice(sink, &slice, start);
+            free(slice.data);
+        }
+        return ;
+    }
+
+    FormatSlice *slices = calloc(threads, sizeof(FormatSlice));
+    pthread_t *ids = malloc(threads * sizeof(pthread_t));
+    if (!slices || !ids)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    uint64_t position = start;
+    size_t first = 0;
+
+    while (first < lines) {
+        size_t used = 0;
+
+        for (; used < threads && first < lines; used++) {
+            FormatSlice *slice = &slices[used];
+
+            slice->records = records;
+            slice->first = first;
+            slice->count = lines - first < SAVE_SLICE_LINES ? lines - first : SAVE_SLICE_LINES;
+            slice->stride = stride;
+            slice->offsets = offsets;
+            first += slice->count;
+        }
+
+        for (size_t t = 1; t < used; t++) {
+            if (pthread_create(&ids[t], NULL, format_slice, &slices[t]) != 0)
+                GENERIC_ERROR("pthread_create: error starting a formatting thread");
+        }
+        format_slice(&slices[0]);
+        for (size_t t = 1; t < used; t++)
+            pthread_join(ids[t], NULL);
+
+        for (size_t t = 0; t < used; t++)
+            position = write_slice(sink, &slices[t], position);
+    }
+
+    for (size_t t = 0; t < threads; t++)
+        free(slices[t].data);
+    free(slices);
+    free(ids);
+}
+
+static size_t save_threads(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return cores > 0 ? (size_t)cores : 1;
+}
+
+static void save_plain(FILE *outfile, Record *saved_records, size_t lines, size_t stride, uint64_t *offsets, size_t threads) {
+    if (!outfile) 
+        GENERIC_ERROR("save_records: outfile file not provided");
+
+    StatsClock clock = stats_phase_begin();
+    LineSink sink = { .io = io_writer_open(outfile), .file = outfile };
+    if (sink.io) {
+        save_formatted(&sink, saved_records, lines, stride, offsets, io_writer_tell(sink.io), threads);
+        io_writer_close(sink.io);
+    } else {
+        off_t start = stride ? ftello(outfile) : 0;
+        if (start < 0)
+            GENERIC_ERROR("ftello: error reading output position");
+
+        save_formatted(&sink, saved_records, lines, stride, offsets, (uint64_t)start, threads);
+    }
+    stats_phase_end(STATS_PHASE_SAVE, clock);
+}
+
+/**
+ * @brief Saves records to a given file.
+ * 
+ * This function writes the specified number of records to the given file. Each record is written
+ * in a comma-separated format.
+ * 
+ * @param outfile Pointer to the file to be written to.
+ * @param saved_records Pointer to the array of records to be saved.
+ * @param lines The number of records to write.
+ */
+void save_records(FILE *outfile, Record *saved_records, size_t lines) {
+    save_records_sampled(outfile, saved_records, lines, 0, NULL);
+}
+
+/**
+ * @brief Saves records to a given file, noting the byte offset of every stride-th line.
+ * 
+ * Same output as save_records(); offsets[i] receives the position in the file where
+ * record i * stride begins, so that a sparse index can be built on top of it.
+ * Lines are formatted on one thread per online core and regular files are written
+ * in large chunks through the I/O backend.
+ * 
+ * @param outfile Pointer to the file to be written to.
+ * @param saved_records Pointer to the array of records to be saved.
+ * @param lines The number of records to write.
+ * @param stride The sampling stride (0 to sample nothing).
+ * @param offsets Array of (lines + stride - 1) / stride offsets (NULL when stride is 0).
+ */
+void save_records_sampled(FILE *outfile, Record *saved_records, size_t lines, size_t stride, uint64_t *offsets) {
+    save_plain(outfile, saved_records, lines, stride, offsets, save_threads());
+}
+
+/**
+ * @brief Saves records like save_records(), formatting on at most threads threads.
+ * 
+ * For callers that already run several saves in parallel, like sort_records_batch(),
+ * and split the cores between them.
+ * 
+ * @param outfile Pointer to the file to be written to.
+ * @param saved_records Pointer to the array of records to be saved.
+ * @param lines The number of records to write.
+ * @param threads The number of formatting threads (at least 1).
+ */
+void save_records_threads(FILE *outfile, Record *saved_records, size_t lines, size_t threads) {
+    save_plain(outfile, saved_records, lines, 0, NULL, threads ? threads : 1);
+}
+
+/**
+ * @brief Saves records to a given file, gzip-compressed on a separate thread.
+ * 
+ * The lines are the same as the ones of save_records(); compression runs on its own
+ * thread (see gzip_stream.c), overlapping with formatting.
+ * 
+ * @param outfile Pointer to the file to be written to.
+ * @param saved_records Pointer to the array of records to be saved.
+ * @param lines The number of records to write.
+ */
+void save_records_gzip(FILE *outfile, Record *saved_records, size_t lines) {
+    if (!outfile)
+        GENERIC_ERROR("save_records_gzip: outfile file not provided");
+
+    StatsClock clock = stats_phase_begin();
+    LineSink sink = { .gz = gzip_writer_open(outfile) };
+    save_formatted(&sink, saved_records, lines, 0, NULL, 0, save_threads());
+    gzip_writer_close(sink.gz);
+    stats_phase_end(STATS_PHASE_SAVE, clock);
+}
+
+struct RecordWriter {
+    LineSink sink;
+    StatsClock clock;
+};
+
+/**
+ * @brief Opens a writer that keeps the output open across several saves.
+ * 
+ * The I/O backend (or stdio for other files) is set up once, so a caller interleaving
+ * many small batches of records with verbatim lines, like merge_records_into(), does
+ * not pay for it on every batch. The save phase spans the writer's lifetime.
+ * 
+ * @param outfile Pointer to the file to be written to.
+ * @return Pointer to the writer, to be closed with record_writer_close().
+ */
+RecordWriter *record_writer_open(FILE *outfile) {
+    if (!outfile)
+        GENERIC_ERROR("record_writer_open: outfile file not provided");
+
+    RecordWriter *writer = malloc(sizeof(RecordWriter));
+    if (!writer)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    writer->clock = stats_phase_begin();
+    writer->sink = (LineSink){ .io = io_writer_open(outfile), .file = outfile };
+    return writer;
+}
+
+/**
+ * @brief Writes records as save_records() does; an empty batch writes nothing.
+ */
+void record_writer_save(RecordWriter *writer, const Record *records, size_t lines) {
+    if (lines > 0)
+        save_formatted(&writer->sink, records, lines, 0, NULL, 0, save_threads());
+}
+
+/**
+ * @brief Writes len bytes of already formatted text verbatim.
+ */
+void record_writer_copy(RecordWriter *writer, const char *data, size_t len) {
+    sink_write(&writer->sink, data, len);
+}
+
+void record_writer_close(RecordWriter *writer) {
+    if (writer->sink.io)
+        io_writer_close(writer->sink.io);
+    stats_phase_end(STATS_PHASE_SAVE, writer->clock);
+    free(writer);
+}
+
+/**
+ * @brief Chooses the sorting algorithm for algo=0 by probing the loaded records.
+ * 
+ * The probe measures existing run structure and the distinct-key ratio on a sample.
+ * Presorted (in either direction) or low-cardinality keys drive the last-element pivot
+ * of quick_sort into its quadratic case, so they are routed to the stable multiway
+ * merge sort, which does the same work as merge_sort in fewer passes; anything
+ * else goes to quick_sort. The decision and the statistics are logged on stderr.
+ * 
+ * @param base Pointer to the array of records.
+ * @param lines The number of elements.
+ * @param size The size of each element.
+ * @param field The field number the records will be sorted by.
+ * @param compar Pointer to the comparison function for that field.
+ * @return The chosen algorithm id (2: quicksort, 3: multiway merge sort).
+ */
+static size_t choose_algorithm(void *base, size_t lines, size_t size, size_t field, int (*compar)(const void *, const void *)) {
+    SortProbe probe;
+    sort_probe(base, lines, size, compar, &probe);
+
+    size_t ordered = probe.ascents > probe.descents ? probe.ascents : probe.descents;
+    double presorted = probe.sampled ? (double)ordered / probe.sampled : 1.0;
+    double distinct = probe.keys ? (double)probe.distinct / probe.keys : 1.0;
+
+    size_t algo = 2;
+    const char *reason = "random order, high cardinality";
+    if (presorted >= AUTO_PRESORTED_RATIO) {
+        algo = 3;
+        reason = probe.ascents >= probe.descents ? "presorted" : "reverse presorted";
+    } else if (distinct < AUTO_DISTINCT_RATIO) {
+        algo = 3;
+        reason = "low cardinality";
+    }
+
+    fprintf(stderr, "auto: lines=%zu field=%zu key=%s element_size=%zu pairs=%zu ascents=%zu descents=%zu "
+                    "presorted=%.3f keys=%zu distinct=%zu distinct_ratio=%.3f -> %s (%s)\n",
+            lines, field, field == 1 ? "string" : field == 2 ? "int" : "double", size,
+            probe.sampled, probe.ascents, probe.descents, presorted, probe.keys, probe.distinct, distinct,
+            algo == 3 ? "multiway_merge_sort" : "quick_sort", reason);
+
+    return algo;
+}
+
+/**
+ * @brief Resolves algo=0 to the algorithm chosen by probing the records; other ids are
+ * returned unchanged.
+ * 
+ * Callers sorting many batches of one input, like pipeline_sort(), resolve the choice
+ * once on a representative batch instead of probing, and logging, every batch.
+ * 
+ * @param records Pointer to the array of records to probe.
+ * @param lines The number of records.
+ * @param field The field number the records will be sorted by.
+ * @param algo The requested algorithm id (see sort_record_array).
+ * @return The algorithm id to sort with (1 to 4).
+ */
+size_t resolve_algorithm(Record *records, size_t lines, size_t field, size_t algo) {
+    if (algo != 0)
+        return algo;
+
+    return choose_algorithm(records, lines, sizeof(Record), field, record_comparator(field));
+}
+
+/**
+ * @brief Sorts an array with the algorithm selected by id.
+ * 
+ * @param base Pointer to the array of records.
+ * @param lines The number of elements.
+ * @param size The size of each element.
+ * @param field The field number to sort by, used to log the automatic choice.
+ * @param compar Pointer to the comparison function for that field.
+ * @param algo The sorting algorithm to use (see sort_record_array).
+ */
+void sort_with_algorithm(void *base, size_t lines, size_t size, size_t field, int (*compar)(const void *, const void *), size_t algo) {
+    StatsClock clock = stats_phase_begin();
+#ifdef SORT_STATS
+    compar = stats_count_comparisons(compar);
+#endif
+
+    if (algo == 0)
+        algo = choose_algorithm(base, lines, size, field, compar);
+
+    switch (algo) {
+        case 1:
+            merge_sort(base, lines, size, compar);
+            break;
+        case 2:
+            quick_sort(base, lines, size, compar);
+            break;
+        case 3:
+            multiway_merge_sort(base, lines, size, compar);
+            break;
+        case 4:
+            inplace_merge_sort(base, lines, size, compar);
+            break;
+        default:
+            GENERIC_ERROR("Error: invalid algorithm id");
+    }
+
+    stats_flush();
+    stats_phase_end(STATS_PHASE_SORT, clock);
+}
+
+/**
+ * @brief Sorts an array of records by the given field with the given algorithm.
+ * 
+ * @param records Pointer to the array of records to be sorted.
+ * @param lines The number of records.
+ * @param field The field number to sort by (1: string, 2: integer, 3: float).
+ * @param algo The sorting algorithm to use (0: automatic, 1: merge sort, 2: quicksort,
+ *             3: multiway merge sort, 4: in-place merge sort).
+ */
+void sort_record_array(Record *records, size_t lines, size_t field, size_t algo) {
+    sort_with_algorithm(records, lines, sizeof(Record), field, record_comparator(field), algo);
+}
@@ -0,0 +1,137 @@
+#include "../include/utils.h"
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+
+static const char *phase_names[STATS_PHASES] = { "count", "load", "sort", "save" };
+
+/**
+ * Totals of one phase over all its calls; calls from concurrent threads add up.
+ */
+typedef struct {
+    uint64_t calls;
+    double wall;
+    double cpu;
+} PhaseTotals;
+
+static int stats_enabled = 0;
+static PhaseTotals phases[STATS_PHASES];
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef SORT_STATS
+__thread SortCounters stats_local;
+static SortCounters stats_total;
+
+// comparator being counted by the calling thread
+static __thread int (*stats_target)(const void *, const void *);
+
+static int counting_comparator(const void *a, const void *b) {
+    STATS_COMPARE();
+    return stats_target(a, b);
+}
+
+/**
+ * @brief Returns a comparator that counts its calls in the thread's counters before calling compar.
+ */
+int (*stats_count_comparisons(int (*compar)(const void *, const void *)))(const void *, const void *) {
+    stats_target = compar;
+    return counting_comparator;
+}
+#endif
+
+/**
+ * @brief Turns on the phase timers; without it, the phase calls return at once.
+ */
+void stats_enable(void) {
+    stats_enabled = 1;
+}
+
+static double clock_seconds(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+StatsClock stats_phase_begin(void) {
+    StatsClock start = { 0.0, 0.0 };
+
+    if (stats_enabled) {
+        start.wall = clock_seconds(CLOCK_MONOTONIC);
+        start.cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    }
+
+    return start;
+}
+
+/**
+ * @brief Adds the wall and CPU time elapsed since start to a phase.
+ *
+ * CPU time is the one of the whole process, so it includes helper threads (formatting,
+ * compression) running on behalf of the phase.
+ */
+void stats_phase_end(size_t phase, StatsClock start) {
+    if (!stats_enabled || phase >= STATS_PHASES)
+        return ;
+
+    double wall = clock_seconds(CLOCK_MONOTONIC) - start.wall;
+    double cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - start.cpu;
+
+    pthread_mutex_lock(&stats_lock);
+    phases[phase].calls++;
+    phases[phase].wall += wall;
+    phases[phase].cpu += cpu;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * @brief Adds the counters of the calling thread to the process totals and resets them.
+ *
+ * Threads flush before finishing their share of the work; it is a no-op when the
+ * counters are compiled out.
+ */
+void stats_flush(void) {
+#ifdef SORT_STATS
+    pthread_mutex_lock(&stats_lock);
+    stats_total.comparisons += stats_local.comparisons;
+    stats_total.bytes_moved += stats_local.bytes_moved;
+    stats_total.allocations += stats_local.allocations;
+    if (stats_local.max_depth > stats_total.max_depth)
+        stats_total.max_depth = stats_local.max_depth;
+    pthread_mutex_unlock(&stats_lock);
+
+    uint64_t depth = stats_local.depth;
+    stats_local = (SortCounters){ .depth = depth };
+#endif
+}
+
+/**
+ * @brief Prints the phase timers, the counters and the peak resident set size as one JSON object.
+ *
+ * "counters" is null unless the program was built with SORT_STATS (make STATS=1).
+ */
+void stats_print_json(FILE *out) {
+    stats_flush();
+
+    fprintf(out, "{\"phases\":{");
+    for (size_t p = 0; p < STATS_PHASES; p++) {
+        fprintf(out, "%s\"%s\":{\"calls\":%llu,\"wall_s\":%.6f,\"cpu_s\":%.6f}",
+                p ? "," : "", phase_names[p], (unsigned long long)phases[p].calls, phases[p].wall, phases[p].cpu);
+    }
+    fprintf(out, "},");
+
+#ifdef SORT_STATS
+    fprintf(out, "\"counters\":{\"comparisons\":%llu,\"bytes_moved\":%llu,\"max_recursion_depth\":%llu,\"allocations\":%llu},",
+            (unsigned long long)stats_total.comparisons, (unsigned long long)stats_total.bytes_moved,
+            (unsigned long long)stats_total.max_depth, (unsigned long long)stats_total.allocations);
+#else
+    fprintf(out, "\"counters\":null,");
+#endif
+
+    struct rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+
+    // ru_maxrss is in kilobytes on Linux
+    fprintf(out, "\"peak_rss_kb\":%ld,\"children_peak_rss_kb\":%ld}\n", self.ru_maxrss, children.ru_maxrss);
+}
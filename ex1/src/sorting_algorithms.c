@@ -1,7 +1,40 @@
 #include "../include/utils.h"
 
+// sort_probe sampling: windows of neighbours for run structure, strided keys for cardinality
+#define PROBE_WINDOWS 32
+#define PROBE_WINDOW_LEN 32
+#define PROBE_KEYS 1024
+
+// multiway_merge_sort: bytes per cache-resident block, runs merged at once (8..64), initial run length
+#define MULTIWAY_BLOCK_BYTES (32 * 1024)
+#define MULTIWAY_FAN_IN 16
+#define MULTIWAY_RUN_LEN 16
+
+// block_partition: elements classified per block before swapping (fits the uint8_t offsets)
+#define PARTITION_BLOCK 128
+
+// inplace_merge_sort: size of the fixed stack buffer, initial run length
+#define INPLACE_BUFFER_BYTES (4 * 1024)
+#define INPLACE_RUN_LEN 16
+
+/**
+ * Tournament tree of losers over up to MULTIWAY_FAN_IN sorted runs of the same source array.
+ * node[0] holds the index of the current overall winner, node[1..k-1] the losers of each match.
+ */
+typedef struct {
+    size_t k;
+    size_t node[MULTIWAY_FAN_IN];
+    size_t pos[MULTIWAY_FAN_IN];
+    size_t end[MULTIWAY_FAN_IN];
+    const int8_t *src;
+    size_t size;
+    int (*compar)(const void*, const void*);
+} LoserTree;
+
 static void swap(void *x, void *y, size_t size) {
     void *temp = malloc(size);
+    STATS_ALLOC();
+    STATS_MOVE(3 * size);
 
     memmove(temp, x, size);
     memmove(x, y, size);
@@ -10,6 +43,28 @@ static void swap(void *x, void *y, size_t size) {
     free(temp);
 }
 
+/**
+ * @brief Swaps two non-overlapping elements through a small fixed-size stack buffer.
+*/
+static void swap_bytes(void *x, void *y, size_t size) {
+    int8_t temp[64];
+    int8_t *a = x;
+    int8_t *b = y;
+
+    STATS_MOVE(3 * size);
+    while (size > 0) {
+        size_t chunk = size < sizeof(temp) ? size : sizeof(temp);
+
+        memcpy(temp, a, chunk);
+        memcpy(a, b, chunk);
+        memcpy(b, temp, chunk);
+
+        a += chunk;
+        b += chunk;
+        size -= chunk;
+    }
+}
+
 /**
  * @brief Merges two sorted subarrays into a single sorted array.
  * 
@@ -25,6 +80,10 @@ static void swap(void *x, void *y, size_t size) {
 static void merge(void *base, size_t left_size, size_t right_size, size_t size, int (*compar)(const void*, const void*)) {
     void *left = malloc(left_size * size);
     void *right = malloc(right_size * size);
+    STATS_ALLOC();
+    STATS_ALLOC();
+    // every element goes to a temporary array and back
+    STATS_MOVE(2 * (left_size + right_size) * size);
 
     memcpy(left, base, left_size * size);
     memcpy(right, (int8_t *)base + left_size * size, right_size * size);
@@ -65,6 +124,9 @@ static void merge(void *base, size_t left_size, size_t right_size, size_t size,
  * elements less than or equal to the pivot are on its left, and all elements
  * greater than the pivot are on its right.
  * 
+ * Reference Lomuto scheme: quick_sort() partitions with block_partition(), which the
+ * tests check against this function.
+ * 
  * @param base Pointer to the base of the array to be partitioned.
  * @param nitems The number of elements in the array.
  * @param size The size of each element in the array.
@@ -89,6 +151,413 @@ static void *partition(void *base, size_t nitems, size_t size, int (*compar)(con
     return index;
 }
 
+/**
+ * @brief Partitions the array around its last element without comparison-driven branches.
+ * 
+ * BlockQuicksort scheme: the left and right ends of the array are scanned in blocks of
+ * PARTITION_BLOCK elements, and the outcome of each comparison is only used to advance
+ * the write index of an offset buffer, so the scan loops contain no branch that depends
+ * on the data. Misplaced elements recorded in both buffers are then swapped in bulk.
+ * The at most 2 * PARTITION_BLOCK elements left between the two scans are partitioned
+ * one by one, reusing the buffered outcomes of a half-processed block, so every element
+ * is compared against the pivot once. The contract is the same as partition():
+ * elements less than or equal to the pivot end up on its left, greater elements on
+ * its right.
+ * 
+ * @param base Pointer to the base of the array to be partitioned.
+ * @param nitems The number of elements in the array.
+ * @param size The size of each element in the array.
+ * @param compar Pointer to the comparison function used to compare elements.
+ * @return Pointer to the pivot element's final position in the array.
+*/
+static void *block_partition(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*)) {
+    int8_t *array = base;
+    int8_t *pivot = array + (nitems - 1) * size;
+
+    uint8_t offsets_l[PARTITION_BLOCK];
+    uint8_t offsets_r[PARTITION_BLOCK];
+    size_t start_l = 0, start_r = 0, num_l = 0, num_r = 0;
+
+    // [0, l) holds elements <= pivot, (r, nitems - 1) elements > pivot
+    size_t l = 0;
+    size_t r = nitems - 2;
+
+    while (nitems >= 2 && r + 1 - l > 2 * PARTITION_BLOCK) {
+        if (num_l == 0) {
+            start_l = 0;
+            for (size_t i = 0; i < PARTITION_BLOCK; i++) {
+                offsets_l[num_l] = (uint8_t)i;
+                num_l += compar(array + (l + i) * size, pivot) > 0;
+            }
+        }
+        if (num_r == 0) {
+            start_r = 0;
+            for (size_t i = 0; i < PARTITION_BLOCK; i++) {
+                offsets_r[num_r] = (uint8_t)i;
+                num_r += compar(array + (r - i) * size, pivot) <= 0;
+            }
+        }
+
+        size_t num = num_l < num_r ? num_l : num_r;
+        for (size_t j = 0; j < num; j++)
+            swap_bytes(array + (l + offsets_l[start_l + j]) * size, array + (r - offsets_r[start_r + j]) * size, size);
+
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+
+        if (num_l == 0)
+            l += PARTITION_BLOCK;
+        if (num_r == 0)
+            r -= PARTITION_BLOCK;
+    }
+
+    if (nitems < 2)
+        return array;
+
+    // Only [l, r] is left to classify: the block with pending offsets was already
+    // compared against the pivot, so its outcome is replayed from the buffer.
+    uint8_t greater[PARTITION_BLOCK];
+    size_t known = l, known_len = 0;
+    if (num_l > 0) {
+        known_len = PARTITION_BLOCK;
+        memset(greater, 0, sizeof(greater));
+        for (size_t j = 0; j < num_l; j++)
+            greater[offsets_l[start_l + j]] = 1;
+    } else if (num_r > 0) {
+        known = r + 1 - PARTITION_BLOCK;
+        known_len = PARTITION_BLOCK;
+        memset(greater, 1, sizeof(greater));
+        for (size_t j = 0; j < num_r; j++)
+            greater[PARTITION_BLOCK - 1 - offsets_r[start_r + j]] = 0;
+    }
+
+    int8_t *index = array + l * size;
+    for (size_t i = l; i <= r; i++) {
+        int8_t *curr = array + i * size;
+        int is_greater = i - known < known_len ? greater[i - known] : compar(curr, pivot) > 0;
+        if (!is_greater) {
+            swap_bytes(index, curr, size);
+            index += size;
+        }
+    }
+
+    // everything after r is greater than the pivot, so index is its final position
+    if (index != pivot)
+        swap_bytes(index, pivot, size);
+
+    return index;
+}
+
+/**
+ * @brief Sorts a small array with a stable insertion sort.
+ * 
+ * @param base Pointer to the base of the array to be sorted.
+ * @param nitems The number of elements in the array.
+ * @param size The size of each element in the array.
+ * @param compar Pointer to the comparison function used to compare elements.
+ * @param temp Scratch space for one element.
+*/
+static void insertion_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*), void *temp) {
+    int8_t *array = base;
+
+    for (size_t i = 1; i < nitems; i++) {
+        size_t j = i;
+
+        while (j > 0 && compar(array + (j - 1) * size, array + i * size) > 0)
+            j--;
+
+        if (j == i)
+            continue;
+
+        STATS_MOVE((i - j + 2) * size);
+        memcpy(temp, array + i * size, size);
+        memmove(array + (j + 1) * size, array + j * size, (i - j) * size);
+        memcpy(array + j * size, temp, size);
+    }
+}
+
+/**
+ * @brief Tells whether the head of run a must be output before the head of run b.
+ * 
+ * Exhausted runs always lose; ties go to the run with the lower index, which comes
+ * first in the source array, so that the merge is stable.
+*/
+static int loser_tree_beats(const LoserTree *tree, size_t a, size_t b) {
+    if (tree->pos[a] == tree->end[a])
+        return 0;
+    if (tree->pos[b] == tree->end[b])
+        return 1;
+
+    int cmp = tree->compar(tree->src + tree->pos[a] * tree->size, tree->src + tree->pos[b] * tree->size);
+
+    return cmp < 0 || (cmp == 0 && a < b);
+}
+
+/**
+ * @brief Plays the initial tournament between the heads of all runs.
+ * 
+ * Leaf i sits at position k + i of an implicit complete binary tree; every internal
+ * node keeps the loser of its match and the overall winner is stored in node[0].
+*/
+static void loser_tree_build(LoserTree *tree) {
+    size_t k = tree->k;
+    size_t winner[2 * MULTIWAY_FAN_IN];
+
+    for (size_t i = 0; i < k; i++)
+        winner[k + i] = i;
+
+    for (size_t n = k - 1; n >= 1; n--) {
+        size_t a = winner[2 * n];
+        size_t b = winner[2 * n + 1];
+
+        if (loser_tree_beats(tree, a, b)) {
+            winner[n] = a;
+            tree->node[n] = b;
+        } else {
+            winner[n] = b;
+            tree->node[n] = a;
+        }
+    }
+
+    tree->node[0] = k > 1 ? winner[1] : 0;
+}
+
+/**
+ * @brief Replays the matches on the path from the leaf of run r to the root.
+ * 
+ * Called after the head of run r, the previous winner, has been consumed.
+*/
+static void loser_tree_replay(LoserTree *tree, size_t r) {
+    for (size_t n = (r + tree->k) / 2; n >= 1; n /= 2) {
+        if (loser_tree_beats(tree, tree->node[n], r)) {
+            size_t temp = tree->node[n];
+            tree->node[n] = r;
+            r = temp;
+        }
+    }
+
+    tree->node[0] = r;
+}
+
+/**
+ * @brief Merges groups of up to MULTIWAY_FAN_IN consecutive sorted runs from src into dst.
+ * 
+ * @param src Pointer to the array holding runs of run_len elements (the last one may be shorter).
+ * @param dst Pointer to the destination array, of the same length as src.
+ * @param nitems The number of elements in the array.
+ * @param size The size of each element in the array.
+ * @param run_len The length of the sorted runs in src.
+ * @param compar Pointer to the comparison function used to compare elements.
+*/
+static void multiway_pass(const void *src, void *dst, size_t nitems, size_t size, size_t run_len, int (*compar)(const void*, const void*)) {
+    LoserTree tree = { .src = src, .size = size, .compar = compar };
+
+    for (size_t start = 0; start < nitems; start += run_len * MULTIWAY_FAN_IN) {
+        tree.k = 0;
+        for (size_t r = start; r < nitems && tree.k < MULTIWAY_FAN_IN; r += run_len) {
+            tree.pos[tree.k] = r;
+            tree.end[tree.k] = r + run_len < nitems ? r + run_len : nitems;
+            tree.k++;
+        }
+
+        size_t total = tree.end[tree.k - 1] - start;
+        int8_t *out = (int8_t *)dst + start * size;
+
+        STATS_MOVE(total * size);
+        loser_tree_build(&tree);
+        for (size_t i = 0; i < total; i++) {
+            size_t winner = tree.node[0];
+
+            memcpy(out + i * size, tree.src + tree.pos[winner] * size, size);
+            tree.pos[winner]++;
+            loser_tree_replay(&tree, winner);
+        }
+    }
+}
+
+/**
+ * @brief Sorts an array by merging runs of run_len elements MULTIWAY_FAN_IN at a time.
+ * 
+ * Passes alternate between base and aux; the sorted result is always left in base.
+ * 
+ * @return The number of passes made over the array.
+*/
+static size_t multiway_merge_runs(void *base, void *aux, size_t nitems, size_t size, size_t run_len, int (*compar)(const void*, const void*)) {
+    void *src = base;
+    void *dst = aux;
+    size_t passes = 0;
+
+    for (; run_len < nitems; run_len *= MULTIWAY_FAN_IN, passes++) {
+        multiway_pass(src, dst, nitems, size, run_len, compar);
+
+        void *temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    if (src != base) {
+        STATS_MOVE(nitems * size);
+        memcpy(base, src, nitems * size);
+    }
+
+    return passes;
+}
+
+/**
+ * @brief Reverses the order of the elements of an array in place.
+*/
+static void reverse(void *base, size_t nitems, size_t size) {
+    int8_t *lo = base;
+    int8_t *hi = (int8_t *)base + nitems * size;
+
+    while (nitems >= 2) {
+        hi -= size;
+        swap_bytes(lo, hi, size);
+        lo += size;
+        nitems -= 2;
+    }
+}
+
+/**
+ * @brief Rotates an array in place so that its element at index left becomes the first one.
+*/
+static void rotate(void *base, size_t left, size_t nitems, size_t size) {
+    if (left == 0 || left == nitems)
+        return ;
+
+    reverse(base, left, size);
+    reverse((int8_t *)base + left * size, nitems - left, size);
+    reverse(base, nitems, size);
+}
+
+/**
+ * @brief Returns the index of the first element of a sorted array that is not less than key.
+*/
+static size_t lower_bound(const void *base, size_t nitems, size_t size, const void *key, int (*compar)(const void*, const void*)) {
+    size_t lo = 0, hi = nitems;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (compar((const int8_t *)base + mid * size, key) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/**
+ * @brief Returns the index of the first element of a sorted array that is greater than key.
+*/
+static size_t upper_bound(const void *base, size_t nitems, size_t size, const void *key, int (*compar)(const void*, const void*)) {
+    size_t lo = 0, hi = nitems;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (compar((const int8_t *)base + mid * size, key) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/**
+ * @brief Sorts a small array with a stable insertion sort that needs no scratch space.
+ * 
+ * Each element is placed with a binary search and moved into position with a rotation.
+*/
+static void rotation_insertion_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*)) {
+    int8_t *array = base;
+
+    for (size_t i = 1; i < nitems; i++) {
+        size_t j = upper_bound(array, i, size, array + i * size, compar);
+
+        rotate(array + j * size, i - j, i - j + 1, size);
+    }
+}
+
+/**
+ * @brief Merges two adjacent sorted runs in place, using the buffer whenever a run fits in it.
+ * 
+ * If the left (right) run fits in the buffer it is moved there and merged forward
+ * (backward) into the array. Otherwise the longer run is cut in half, the matching cut
+ * in the other run is found by binary search, the two middle pieces are swapped with a
+ * rotation and both halves are merged recursively. Ties always favour the left run.
+ * 
+ * @param base Pointer to the first element of the left run.
+ * @param left_size The number of elements in the left run.
+ * @param right_size The number of elements in the right run, which follows the left one.
+ * @param size The size of each element in the array.
+ * @param compar Pointer to the comparison function used to compare elements.
+ * @param buffer Scratch space for buffer_items elements (may be NULL when buffer_items is 0).
+ * @param buffer_items The capacity of the buffer, in elements.
+*/
+static void inplace_merge(void *base, size_t left_size, size_t right_size, size_t size, int (*compar)(const void*, const void*), void *buffer, size_t buffer_items) {
+    if (left_size == 0 || right_size == 0)
+        return ;
+
+    int8_t *left = base;
+    int8_t *right = left + left_size * size;
+
+    if (compar(right - size, right) <= 0)
+        return ;
+
+    if (left_size == 1 && right_size == 1) {
+        swap_bytes(left, right, size);
+    } else if (left_size <= buffer_items) {
+        int8_t *temp = buffer;
+        size_t i = 0, j = 0, k = 0;
+
+        STATS_MOVE((2 * left_size + right_size) * size);
+        memcpy(temp, left, left_size * size);
+        while (i < left_size && j < right_size) {
+            if (compar(right + j * size, temp + i * size) < 0)
+                memcpy(left + k++ * size, right + j++ * size, size);
+            else
+                memcpy(left + k++ * size, temp + i++ * size, size);
+        }
+        memcpy(left + k * size, temp + i * size, (left_size - i) * size);
+    } else if (right_size <= buffer_items) {
+        int8_t *temp = buffer;
+        size_t i = left_size, j = right_size, k = left_size + right_size;
+
+        STATS_MOVE((left_size + 2 * right_size) * size);
+        memcpy(temp, right, right_size * size);
+        while (i > 0 && j > 0) {
+            if (compar(temp + (j - 1) * size, left + (i - 1) * size) < 0)
+                memcpy(left + --k * size, left + --i * size, size);
+            else
+                memcpy(left + --k * size, temp + --j * size, size);
+        }
+        memcpy(left, temp, j * size);
+    } else {
+        size_t left_cut, right_cut;
+
+        if (left_size > right_size) {
+            left_cut = left_size / 2;
+            right_cut = lower_bound(right, right_size, size, left + left_cut * size, compar);
+        } else {
+            right_cut = right_size / 2;
+            left_cut = upper_bound(left, left_size, size, right + right_cut * size, compar);
+        }
+
+        rotate(left + left_cut * size, left_size - left_cut, left_size - left_cut + right_cut, size);
+
+        int8_t *middle = left + (left_cut + right_cut) * size;
+        STATS_ENTER();
+        inplace_merge(left, left_cut, right_cut, size, compar, buffer, buffer_items);
+        inplace_merge(middle, left_size - left_cut, right_size - right_cut, size, compar, buffer, buffer_items);
+        STATS_LEAVE();
+    }
+}
+
 /**
  * @brief Sorts an array using the merge sort algorithm.
  * 
@@ -108,8 +577,10 @@ void merge_sort(void *base, size_t nitems, size_t size, int (*compar)(const void
 
     size_t mid = nitems / 2;
 
+    STATS_ENTER();
     merge_sort(base, mid, size, compar);
     merge_sort(base + mid * size, nitems - mid, size, compar);
+    STATS_LEAVE();
 
     merge(base, mid, nitems - mid, size, compar);
 }
@@ -131,10 +602,166 @@ void quick_sort(void *base, size_t nitems, size_t size, int (*compar)(const void
     if(nitems <= 1)
         return ;
 
-    void *pivot = partition(base, nitems, size, compar);
+    void *pivot = block_partition(base, nitems, size, compar);
 
     size_t index = ((int8_t *)pivot - (int8_t *)base) / size;
 
+    STATS_ENTER();
     quick_sort(base, index, size, compar);
     quick_sort((int8_t *)pivot + size, nitems - index - 1, size, compar);
-}
\ No newline at end of file
+    STATS_LEAVE();
+}
+
+/**
+ * @brief Sorts an array using a multiway merge sort driven by a loser tree.
+ * 
+ * Cache-sized blocks are sorted first, from insertion-sorted runs merged inside the block;
+ * the sorted blocks are then merged MULTIWAY_FAN_IN at a time, so that each pass streams
+ * the whole array once and the number of passes is log_k(nitems / block) instead of
+ * log_2(nitems). Like merge_sort, the sort is stable and uses O(nitems) extra memory.
+ * 
+ * @param base Pointer to the base of the array to be sorted.
+ * @param nitems The number of elements in the array.
+ * @param size The size of each element in the array.
+ * @param compar Pointer to the comparison function used to compare elements.
+*/
+void multiway_merge_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*)) {
+    ARGUMENTS_ERROR(base, compar);
+
+    if (nitems <= 1)
+        return ;
+
+    int8_t *aux = malloc(nitems * size);
+    if (!aux)
+        GENERIC_ERROR("malloc: memory allocation failed");
+    STATS_ALLOC();
+
+    size_t block = MULTIWAY_BLOCK_BYTES / size > MULTIWAY_RUN_LEN ? MULTIWAY_BLOCK_BYTES / size : MULTIWAY_RUN_LEN;
+
+    for (size_t start = 0; start < nitems; start += block) {
+        size_t len = nitems - start < block ? nitems - start : block;
+        int8_t *chunk = (int8_t *)base + start * size;
+
+        for (size_t r = 0; r < len; r += MULTIWAY_RUN_LEN)
+            insertion_sort(chunk + r * size, len - r < MULTIWAY_RUN_LEN ? len - r : MULTIWAY_RUN_LEN, size, compar, aux + start * size);
+
+        multiway_merge_runs(chunk, aux + start * size, len, size, MULTIWAY_RUN_LEN, compar);
+    }
+
+    multiway_merge_runs(base, aux, nitems, size, block, compar);
+
+    free(aux);
+}
+
+/**
+ * @brief Sorts an array with a stable in-place merge sort, using a caller-provided buffer.
+ * 
+ * Runs of INPLACE_RUN_LEN elements are insertion-sorted and then merged bottom-up with
+ * inplace_merge(), so the only extra memory is the buffer and O(log nitems) stack. Merges
+ * whose shorter run fits in the buffer are linear; larger ones fall back to rotations.
+ * 
+ * @param base Pointer to the base of the array to be sorted.
+ * @param nitems The number of elements in the array.
+ * @param size The size of each element in the array.
+ * @param compar Pointer to the comparison function used to compare elements.
+ * @param buffer Scratch space for buffer_items elements (may be NULL when buffer_items is 0).
+ * @param buffer_items The capacity of the buffer, in elements.
+*/
+void inplace_merge_sort_buffer(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*), void *buffer, size_t buffer_items) {
+    ARGUMENTS_ERROR(base, compar);
+    if (!buffer && buffer_items > 0)
+        GENERIC_ERROR("inplace_merge_sort_buffer: buffer not provided");
+
+    if (nitems <= 1)
+        return ;
+
+    int8_t *array = base;
+
+    for (size_t start = 0; start < nitems; start += INPLACE_RUN_LEN)
+        rotation_insertion_sort(array + start * size, nitems - start < INPLACE_RUN_LEN ? nitems - start : INPLACE_RUN_LEN, size, compar);
+
+    for (size_t width = INPLACE_RUN_LEN; width < nitems; width *= 2) {
+        for (size_t start = 0; start + width < nitems; start += 2 * width) {
+            size_t right_size = nitems - start - width < width ? nitems - start - width : width;
+
+            inplace_merge(array + start * size, width, right_size, size, compar, buffer, buffer_items);
+        }
+    }
+}
+
+/**
+ * @brief Sorts an array with a stable in-place merge sort.
+ * 
+ * Same as inplace_merge_sort_buffer() with a fixed stack buffer of INPLACE_BUFFER_BYTES,
+ * so the extra memory does not grow with nitems.
+ * 
+ * @param base Pointer to the base of the array to be sorted.
+ * @param nitems The number of elements in the array.
+ * @param size The size of each element in the array.
+ * @param compar Pointer to the comparison function used to compare elements.
+*/
+void inplace_merge_sort(void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*)) {
+    int8_t buffer[INPLACE_BUFFER_BYTES];
+
+    inplace_merge_sort_buffer(base, nitems, size, compar, buffer, sizeof(buffer) / size);
+}
+
+/**
+ * @brief Samples an array to estimate how presorted it is and how many distinct keys it holds.
+ * 
+ * Run structure is measured by comparing neighbours inside PROBE_WINDOWS evenly spaced
+ * windows of PROBE_WINDOW_LEN elements; cardinality is estimated by sorting a strided
+ * sample of at most PROBE_KEYS elements and counting the distinct keys in it. The cost is
+ * bounded by the sample sizes and does not depend on nitems.
+ * 
+ * @param base Pointer to the base of the array to be probed.
+ * @param nitems The number of elements in the array.
+ * @param size The size of each element in the array.
+ * @param compar Pointer to the comparison function used to compare elements.
+ * @param probe Pointer to the structure receiving the measured statistics.
+*/
+void sort_probe(const void *base, size_t nitems, size_t size, int (*compar)(const void*, const void*), SortProbe *probe) {
+    ARGUMENTS_ERROR(base, compar);
+    if (!probe)
+        GENERIC_ERROR("sort_probe: probe not provided");
+
+    memset(probe, 0, sizeof(SortProbe));
+    if (nitems == 0)
+        return ;
+
+    size_t windows = nitems <= PROBE_WINDOWS * PROBE_WINDOW_LEN ? 1 : PROBE_WINDOWS;
+    size_t window_len = windows == 1 ? nitems : PROBE_WINDOW_LEN;
+    size_t window_stride = windows == 1 ? 0 : (nitems - window_len) / (windows - 1);
+
+    for (size_t w = 0; w < windows; w++) {
+        const int8_t *window = (const int8_t *)base + w * window_stride * size;
+
+        for (size_t i = 1; i < window_len; i++) {
+            int cmp = compar(window + (i - 1) * size, window + i * size);
+
+            probe->ascents += cmp < 0;
+            probe->descents += cmp > 0;
+            probe->sampled++;
+        }
+    }
+
+    probe->keys = nitems < PROBE_KEYS ? nitems : PROBE_KEYS;
+    size_t key_stride = nitems / probe->keys;
+
+    int8_t *keys = malloc(probe->keys * size);
+    if (!keys)
+        GENERIC_ERROR("malloc: memory allocation failed");
+    STATS_ALLOC();
+    STATS_MOVE(probe->keys * size);
+
+    for (size_t i = 0; i < probe->keys; i++)
+        memcpy(keys + i * size, (const int8_t *)base + i * key_stride * size, size);
+
+    merge_sort(keys, probe->keys, size, compar);
+
+    probe->distinct = 1;
+    for (size_t i = 1; i < probe->keys; i++)
+        probe->distinct += compar(keys + (i - 1) * size, keys + i * size) != 0;
+
+    free(keys);
+}
@@ -0,0 +1,280 @@
+#include "../include/utils.h"
+
+// "RIDX" followed by the format version
+#define SPARSE_INDEX_MAGIC 0x58444952u
+#define SPARSE_INDEX_VERSION 1u
+
+static int compare_keys(const SparseIndex *index, const SparseIndexKey *a, const SparseIndexKey *b) {
+    switch (index->header.field) {
+        case 1:
+            return strcmp(index->pool + a->str, index->pool + b->str);
+        case 2:
+            return (a->i > b->i) - (a->i < b->i);
+        default:
+            return (a->d > b->d) - (a->d < b->d);
+    }
+}
+
+/**
+ * @brief Lays out sorted entries in Eytzinger (breadth-first) order.
+ *
+ * Slot k (1-based) holds the root of the subtree whose children are slots 2k and 2k + 1,
+ * so a search walks down the array with a predictable stride instead of jumping across
+ * it as a binary search does.
+ *
+ * @return The next sorted position to place.
+ */
+static size_t eytzinger_fill(const SparseIndexEntry *sorted, SparseIndexEntry *entries, size_t i, size_t k, size_t count) {
+    if (k <= count) {
+        i = eytzinger_fill(sorted, entries, i, 2 * k, count);
+        entries[k - 1] = sorted[i++];
+        i = eytzinger_fill(sorted, entries, i, 2 * k + 1, count);
+    }
+
+    return i;
+}
+
+/**
+ * @brief Builds the sparse index of a sorted array of records.
+ *
+ * Every stride-th record contributes its key; each entry stores the offset of the
+ * previous sampled line, which is where a scan for keys greater than or equal to the
+ * entry's key has to start when duplicates straddle the sample.
+ *
+ * @param records Pointer to the sorted array of records.
+ * @param lines The number of records.
+ * @param field The field the records are sorted by (1: string, 2: integer, 3: float).
+ * @param stride The sampling stride.
+ * @param offsets The byte offsets of the sampled lines, as filled by save_records_sampled().
+ * @return Pointer to the new index, to be released with sparse_index_free().
+ */
+SparseIndex *sparse_index_build(const Record *records, size_t lines, size_t field, size_t stride, const uint64_t *offsets) {
+    if (!records || !offsets)
+        GENERIC_ERROR("sparse_index_build: records not provided");
+    if (stride == 0 || field < 1 || field > 3)
+        GENERIC_ERROR("sparse_index_build: invalid stride or field");
+
+    size_t count = (lines + stride - 1) / stride;
+
+    SparseIndex *index = calloc(1, sizeof(SparseIndex));
+    if (!index)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    SparseIndexEntry *sorted = malloc((count ? count : 1) * sizeof(SparseIndexEntry));
+    index->entries = malloc((count ? count : 1) * sizeof(SparseIndexEntry));
+    if (!sorted || !index->entries)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    size_t pool_size = 0;
+    if (field == 1) {
+        for (size_t j = 0; j < count; j++)
+            pool_size += strlen(records[j * stride].field_str) + 1;
+
+        index->pool = malloc(pool_size ? pool_size : 1);
+        if (!index->pool)
+            GENERIC_ERROR("malloc: memory allocation failed");
+    }
+
+    size_t used = 0;
+    for (size_t j = 0; j < count; j++) {
+        const Record *record = &records[j * stride];
+
+        sorted[j].scan_from = j > 0 ? offsets[j - 1] : offsets[0];
+        if (field == 1) {
+            size_t len = strlen(record->field_str) + 1;
+
+            memcpy(index->pool + used, record->field_str, len);
+            sorted[j].key.str = used;
+            used += len;
+        } else if (field == 2) {
+            sorted[j].key.i = record->field_int;
+        } else {
+            // keep the key as printed, so that it compares like the lines of the file
+            char text[64];
+            snprintf(text, sizeof(text), "%f", record->field_fp);
+            sorted[j].key.d = atof(text);
+        }
+    }
+
+    eytzinger_fill(sorted, index->entries, 0, 1, count);
+    free(sorted);
+
+    index->header = (SparseIndexHeader){
+        .magic = SPARSE_INDEX_MAGIC,
+        .version = SPARSE_INDEX_VERSION,
+        .field = (uint32_t)field,
+        .stride = stride,
+        .count = count,
+        .lines = lines,
+        .last_offset = count ? offsets[count - 1] : 0,
+        .pool_size = pool_size
+    };
+
+    return index;
+}
+
+/**
+ * @brief Writes a sparse index to a sidecar file: header, entries, then the string pool.
+ */
+void sparse_index_write(const SparseIndex *index, const char *path) {
+    if (!index || !path)
+        GENERIC_ERROR("sparse_index_write: index not provided");
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        GENERIC_ERROR("fopen: error opening index file");
+
+    if (fwrite(&index->header, sizeof(SparseIndexHeader), 1, file) != 1
+        || fwrite(index->entries, sizeof(SparseIndexEntry), index->header.count, file) != index->header.count
+        || fwrite(index->pool, 1, index->header.pool_size, file) != index->header.pool_size)
+        GENERIC_ERROR("fwrite: error writing index file");
+
+    if (fclose(file) != 0)
+        GENERIC_ERROR("fclose: error writing index file");
+}
+
+/**
+ * @brief Reads a sparse index written by sparse_index_write().
+ *
+ * @return Pointer to the index, to be released with sparse_index_free().
+ */
+SparseIndex *sparse_index_read(const char *path) {
+    if (!path)
+        GENERIC_ERROR("sparse_index_read: path not provided");
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        GENERIC_ERROR("fopen: error opening index file");
+
+    SparseIndex *index = calloc(1, sizeof(SparseIndex));
+    if (!index)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    if (fread(&index->header, sizeof(SparseIndexHeader), 1, file) != 1)
+        GENERIC_ERROR("fread: error reading index header");
+    if (index->header.magic != SPARSE_INDEX_MAGIC || index->header.version != SPARSE_INDEX_VERSION)
+        GENERIC_ERROR("sparse_index_read: not a sparse index file");
+
+    index->entries = malloc((index->header.count ? index->header.count : 1) * sizeof(SparseIndexEntry));
+    index->pool = malloc(index->header.pool_size ? index->header.pool_size : 1);
+    if (!index->entries || !index->pool)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    if (fread(index->entries, sizeof(SparseIndexEntry), index->header.count, file) != index->header.count
+        || fread(index->pool, 1, index->header.pool_size, file) != index->header.pool_size)
+        GENERIC_ERROR("fread: error reading index file");
+
+    fclose(file);
+
+    return index;
+}
+
+void sparse_index_free(SparseIndex *index) {
+    if (!index)
+        return ;
+
+    free(index->entries);
+    free(index->pool);
+    free(index);
+}
+
+/**
+ * @brief Returns the byte offset where a scan for keys greater than or equal to key must start.
+ *
+ * Branch-free Eytzinger lower bound: the walk always runs to a leaf, the comparison
+ * result selects the child, and the trailing ones of the final position tell how far
+ * back up the tree the first entry not less than key is.
+ *
+ * @param index Pointer to the index.
+ * @param key Pointer to the key, as parsed by sparse_index_parse_key().
+ * @return Offset of the last sampled line whose key is less than key, or 0.
+ */
+uint64_t sparse_index_seek(const SparseIndex *index, const SparseIndexKey *key) {
+    if (!index || !key)
+        GENERIC_ERROR("sparse_index_seek: index not provided");
+
+    const SparseIndexEntry *entries = index->entries;
+    size_t count = index->header.count;
+    size_t k = 1;
+
+    while (k <= count) {
+        __builtin_prefetch(entries + 4 * k);
+        k = 2 * k + (compare_keys(index, &entries[k - 1].key, key) < 0);
+    }
+    k >>= __builtin_ffsll(~k);
+
+    if (k == 0)
+        return index->header.last_offset;
+
+    return entries[k - 1].scan_from;
+}
+
+/**
+ * @brief Parses a key given on the command line according to the indexed field.
+ *
+ * String keys are appended to the string pool of the index, so that they are compared
+ * with the stored keys the same way the stored keys are compared with each other.
+ */
+SparseIndexKey sparse_index_parse_key(SparseIndex *index, const char *text) {
+    SparseIndexKey key = {0};
+
+    switch (index->header.field) {
+        case 1: {
+            size_t len = strlen(text) + 1;
+
+            index->pool = realloc(index->pool, index->header.pool_size + len);
+            if (!index->pool)
+                GENERIC_ERROR("realloc: memory allocation failed");
+
+            memcpy(index->pool + index->header.pool_size, text, len);
+            key.str = index->header.pool_size;
+            index->header.pool_size += len;
+            break;
+        }
+        case 2:
+            key.i = atoi(text);
+            break;
+        default:
+            key.d = atof(text);
+    }
+
+    return key;
+}
+
+/**
+ * @brief Compares the indexed field of a CSV line with a parsed key.
+ *
+ * @param index Pointer to the index, whose field selects the column.
+ * @param line The CSV line, in the "id,field_str,field_int,field_fp" format.
+ * @param key Pointer to the key.
+ * @return A number less than, equal to or greater than zero if the line's key is less than,
+ *         equal to or greater than key.
+ */
+int sparse_index_compare_line(const SparseIndex *index, const char *line, const SparseIndexKey *key) {
+    const char *column = line;
+    for (uint32_t f = 0; f < index->header.field && column; f++) {
+        column = strchr(column, ',');
+        if (column)
+            column++;
+    }
+    if (!column)
+        GENERIC_ERROR("sparse_index_compare_line: malformed line");
+
+    switch (index->header.field) {
+        case 1: {
+            const char *s = index->pool + key->str;
+            size_t len = strcspn(column, ",");
+            int cmp = strncmp(column, s, len);
+
+            return cmp != 0 ? cmp : -(s[len] != '\0');
+        }
+        case 2: {
+            int64_t value = atoi(column);
+            return (value > key->i) - (value < key->i);
+        }
+        default: {
+            double value = atof(column);
+            return (value > key->d) - (value < key->d);
+        }
+    }
+}
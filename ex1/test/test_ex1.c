@@ -1,11 +1,25 @@
 #include "../../lib/unity.h"
 #include "../src/sorting_algorithms.c"
+#include "../src/sparse_index.c"
+#include "../src/records.c"
+#include "../src/io_backend.c"
+#include "../src/gzip_stream.c"
+#include "../src/pipeline_sort.c"
+#include "../src/distributed_sort.c"
+#include "../src/batch_sort.c"
+#include "../src/merge_into.c"
+#include "../src/projection.c"
+#include "../src/sort_stats.c"
 
 // compare functions
 static int compare_int(const void *a, const void *b) { 
     return (*(const int *)a - *(const int *)b); 
 }
 
+static int compare_int_safe(const void *a, const void *b) {
+    return (*(const int *)a > *(const int *)b) - (*(const int *)a < *(const int *)b);
+}
+
 static int compare_float(const void *a, const void *b) { 
     return (*(const float *)a > *(const float *)b) - (*(const float *)a < *(const float *)b); 
 }
@@ -14,6 +28,29 @@ static int compare_string(const void *a, const void *b) {
     return strcmp(*(const char**)a, *(const char**)b);
 }
 
+// reference output: the load, stable sort and save that sort_records() performs
+static void sort_records_reference(FILE *infile, FILE *outfile, size_t field) {
+    size_t lines;
+    Record *records = read_records(infile, &lines);
+
+    sort_record_array(records, lines, field, 1);
+    save_records(outfile, records, lines);
+
+    for (size_t i = 0; i < lines; i++)
+        free(records[i].field_str);
+    free(records);
+}
+
+static void assert_same_contents(FILE *expected, FILE *actual) {
+    rewind(expected);
+    rewind(actual);
+
+    int c;
+    while ((c = fgetc(expected)) != EOF)
+        TEST_ASSERT_EQUAL_INT(c, fgetc(actual));
+    TEST_ASSERT_EQUAL_INT(EOF, fgetc(actual));
+}
+
 // merge sort tests
 static void merge_sort_best_case_int() {
     int input[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
@@ -201,6 +238,74 @@ static void test_partition_string() {
     }
 }
 
+// block partition tests
+static size_t partition_comparisons;
+
+static int compare_int_counted(const void *a, const void *b) {
+    partition_comparisons++;
+    return compare_int(a, b);
+}
+
+static void test_block_partition_int() {
+    int array[] = {3, 1, 4, 5, 2};
+    size_t nitems = sizeof(array) / sizeof(array[0]);
+
+    void *pivot = block_partition(array, nitems, sizeof(int), compare_int);
+
+    size_t pivot_index = ((int8_t *)pivot - (int8_t *)array) / sizeof(int);
+    TEST_ASSERT_EQUAL_INT(1, pivot_index);
+    TEST_ASSERT_EQUAL_INT(2, array[pivot_index]);
+}
+
+static void test_block_partition_large_int() {
+    size_t nitems = 10000;
+    int *array = malloc(nitems * sizeof(int));
+
+    srand(4);
+    for (size_t i = 0; i < nitems; i++)
+        array[i] = rand() % 500;
+    int pivot_value = array[nitems - 1];
+    int *reference = malloc(nitems * sizeof(int));
+    memcpy(reference, array, nitems * sizeof(int));
+
+    partition_comparisons = 0;
+    int *pivot = block_partition(array, nitems, sizeof(int), compare_int_counted);
+
+    // one comparison per element besides the pivot, and the split of partition()
+    size_t pivot_index = pivot - array;
+    TEST_ASSERT_EQUAL_INT(nitems - 1, partition_comparisons);
+    TEST_ASSERT_EQUAL_INT((int *)partition(reference, nitems, sizeof(int), compare_int) - reference, pivot_index);
+    TEST_ASSERT_EQUAL_INT(pivot_value, *pivot);
+
+    for (size_t i = 0; i < pivot_index; i++)
+        TEST_ASSERT_TRUE(array[i] <= pivot_value);
+
+    for (size_t i = pivot_index + 1; i < nitems; i++)
+        TEST_ASSERT_TRUE(array[i] > pivot_value);
+
+    free(reference);
+    free(array);
+}
+
+static void test_block_partition_large_string() {
+    const char *words[] = {"apple", "banana", "cherry", "date", "elderberry", "fig", "grape"};
+    size_t nitems = 1000;
+    const char **array = malloc(nitems * sizeof(const char *));
+
+    for (size_t i = 0; i < nitems; i++)
+        array[i] = words[(i * 5 + i / 7) % 7];
+
+    const char **pivot = block_partition(array, nitems, sizeof(const char *), compare_string);
+
+    for (const char **curr = array; curr < pivot; curr++)
+        TEST_ASSERT_TRUE(compare_string(curr, pivot) <= 0);
+
+    for (const char **curr = pivot + 1; curr < array + nitems; curr++)
+        TEST_ASSERT_TRUE(compare_string(curr, pivot) > 0);
+
+    free(array);
+}
+
 // quick sort tests
 static void quick_sort_worst_case_int() {
     int input[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
@@ -280,6 +385,604 @@ static void quick_sort_duplicate_elements_string() {
     TEST_ASSERT_EQUAL_STRING_ARRAY(expected_output, input, sizeof(input) / sizeof(const char *));
 }
 
+static void quick_sort_large_random_int() {
+    size_t nitems = 100000;
+    int *input = malloc(nitems * sizeof(int));
+
+    srand(5);
+    for (size_t i = 0; i < nitems; i++)
+        input[i] = rand();
+
+    quick_sort(input, nitems, sizeof(int), compare_int_safe);
+
+    for (size_t i = 1; i < nitems; i++)
+        TEST_ASSERT_TRUE(input[i - 1] <= input[i]);
+
+    free(input);
+}
+
+// multiway merge sort tests
+static void multiway_merge_sort_medium_case_int() {
+    int input[] = {5, 2, 1, 7, 6, 3, 8, 4, 0, 9};
+    int expected_output[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    multiway_merge_sort(input, sizeof(input) / sizeof(input[0]), sizeof(int), compare_int);
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected_output, input, sizeof(input) / sizeof(int));
+}
+
+static void multiway_merge_sort_duplicate_elements_float() {
+    float input[] = {0.2, 0.1, 0.0, 0.0, 0.2, 0.0, 0.2, 0.1, 0.1, 0.0};
+    float expected_output[] = {0.0, 0.0, 0.0, 0.0, 0.1, 0.1, 0.1, 0.2, 0.2, 0.2};
+
+    multiway_merge_sort(input, sizeof(input) / sizeof(input[0]), sizeof(float), compare_float);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected_output, input, sizeof(input) / sizeof(float));
+}
+
+static void multiway_merge_sort_medium_case_string() {
+    const char *input[] = {"date", "apple", "banana", "elderberry", "cherry"};
+    const char *expected_output[] = {"apple", "banana", "cherry", "date", "elderberry"};
+
+    multiway_merge_sort(input, sizeof(input) / sizeof(input[0]), sizeof(const char *), compare_string);
+    TEST_ASSERT_EQUAL_STRING_ARRAY(expected_output, input, sizeof(input) / sizeof(const char *));
+}
+
+// pairs sorted on key only, to check that equal keys keep their input order
+typedef struct {
+    int key;
+    int index;
+} Pair;
+
+static int compare_pair_key(const void *a, const void *b) {
+    return ((const Pair *)a)->key - ((const Pair *)b)->key;
+}
+
+static void assert_sorted_and_stable(Pair *pairs, size_t nitems) {
+    for (size_t i = 1; i < nitems; i++) {
+        TEST_ASSERT_TRUE(pairs[i - 1].key <= pairs[i].key);
+        if (pairs[i - 1].key == pairs[i].key)
+            TEST_ASSERT_TRUE(pairs[i - 1].index < pairs[i].index);
+    }
+}
+
+static void multiway_merge_sort_large_input_is_stable() {
+    size_t nitems = 200000;
+    Pair *input = malloc(nitems * sizeof(Pair));
+
+    srand(1);
+    for (size_t i = 0; i < nitems; i++) {
+        input[i].key = rand() % 1000;
+        input[i].index = (int)i;
+    }
+
+    multiway_merge_sort(input, nitems, sizeof(Pair), compare_pair_key);
+
+    assert_sorted_and_stable(input, nitems);
+
+    free(input);
+}
+
+// in-place merge sort tests
+static void inplace_merge_sort_medium_case_int() {
+    int input[] = {5, 2, 1, 7, 6, 3, 8, 4, 0, 9};
+    int expected_output[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    inplace_merge_sort(input, sizeof(input) / sizeof(input[0]), sizeof(int), compare_int);
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected_output, input, sizeof(input) / sizeof(int));
+}
+
+static void inplace_merge_sort_duplicate_elements_string() {
+    const char *input[] = {"banana", "apple", "banana", "apple", "cherry"};
+    const char *expected_output[] = {"apple", "apple", "banana", "banana", "cherry"};
+
+    inplace_merge_sort(input, sizeof(input) / sizeof(input[0]), sizeof(const char *), compare_string);
+    TEST_ASSERT_EQUAL_STRING_ARRAY(expected_output, input, sizeof(input) / sizeof(const char *));
+}
+
+static void inplace_merge_sort_large_input_is_stable() {
+    size_t nitems = 100000;
+    Pair *input = malloc(nitems * sizeof(Pair));
+
+    srand(2);
+    for (size_t i = 0; i < nitems; i++) {
+        input[i].key = rand() % 1000;
+        input[i].index = (int)i;
+    }
+
+    inplace_merge_sort(input, nitems, sizeof(Pair), compare_pair_key);
+    assert_sorted_and_stable(input, nitems);
+
+    free(input);
+}
+
+static void inplace_merge_sort_without_buffer_is_stable() {
+    size_t nitems = 20000;
+    Pair *input = malloc(nitems * sizeof(Pair));
+
+    srand(3);
+    for (size_t i = 0; i < nitems; i++) {
+        input[i].key = rand() % 100;
+        input[i].index = (int)i;
+    }
+
+    inplace_merge_sort_buffer(input, nitems, sizeof(Pair), compare_pair_key, NULL, 0);
+    assert_sorted_and_stable(input, nitems);
+
+    free(input);
+}
+
+// sort probe tests
+static void sort_probe_sorted_int() {
+    int input[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    SortProbe probe;
+
+    sort_probe(input, sizeof(input) / sizeof(input[0]), sizeof(int), compare_int, &probe);
+
+    TEST_ASSERT_EQUAL_INT(9, probe.sampled);
+    TEST_ASSERT_EQUAL_INT(9, probe.ascents);
+    TEST_ASSERT_EQUAL_INT(0, probe.descents);
+    TEST_ASSERT_EQUAL_INT(10, probe.distinct);
+}
+
+static void sort_probe_reversed_float() {
+    float input[] = {0.9, 0.8, 0.7, 0.6, 0.5, 0.4, 0.3, 0.2, 0.1, 0.0};
+    SortProbe probe;
+
+    sort_probe(input, sizeof(input) / sizeof(input[0]), sizeof(float), compare_float, &probe);
+
+    TEST_ASSERT_EQUAL_INT(0, probe.ascents);
+    TEST_ASSERT_EQUAL_INT(9, probe.descents);
+    TEST_ASSERT_EQUAL_INT(10, probe.distinct);
+}
+
+static void sort_probe_duplicate_elements_string() {
+    const char *input[] = {"banana", "apple", "banana", "apple", "cherry", "apple"};
+    SortProbe probe;
+
+    sort_probe(input, sizeof(input) / sizeof(input[0]), sizeof(const char *), compare_string, &probe);
+
+    TEST_ASSERT_EQUAL_INT(6, probe.keys);
+    TEST_ASSERT_EQUAL_INT(3, probe.distinct);
+    TEST_ASSERT_EQUAL_INT(5, probe.ascents + probe.descents);
+}
+
+static void sort_probe_large_input_is_sampled() {
+    size_t nitems = 100000;
+    int *input = malloc(nitems * sizeof(int));
+    for (size_t i = 0; i < nitems; i++)
+        input[i] = (int)(i % 7);
+
+    SortProbe probe;
+    sort_probe(input, nitems, sizeof(int), compare_int, &probe);
+
+    TEST_ASSERT_TRUE(probe.sampled < nitems / 10);
+    TEST_ASSERT_EQUAL_INT(PROBE_KEYS, probe.keys);
+    TEST_ASSERT_EQUAL_INT(7, probe.distinct);
+
+    free(input);
+}
+
+// I/O backend tests
+static void records_round_trip_across_chunks() {
+    // enough lines for several chunks, the last one without a newline
+    const size_t lines = 3 * IO_CHUNK_BYTES / 24;
+    FILE *infile = tmpfile();
+    FILE *outfile = tmpfile();
+    TEST_ASSERT_NOT_NULL(infile);
+    TEST_ASSERT_NOT_NULL(outfile);
+
+    for (size_t i = 0; i < lines; i++)
+        fprintf(infile, "%zu,w%zu,%zu,%f%s", i, i % 97, lines - i, i / 8.0, i + 1 < lines ? "\n" : "");
+    rewind(infile);
+
+    TEST_ASSERT_EQUAL_INT(lines, count_lines(infile));
+    Record *records = load_records(infile, lines);
+    TEST_ASSERT_EQUAL_INT(0, records[0].id);
+    TEST_ASSERT_EQUAL_INT(lines - 1, records[lines - 1].id);
+    TEST_ASSERT_EQUAL_STRING("w0", records[97].field_str);
+    TEST_ASSERT_TRUE(records[lines - 1].field_fp == (lines - 1) / 8.0);
+
+    save_records(outfile, records, lines);
+    fputs("tail\n", outfile);
+    rewind(outfile);
+
+    char buffer[BUFSIZ];
+    for (size_t i = 0; i < lines; i++) {
+        char expected[64];
+        snprintf(expected, sizeof(expected), "%zu,w%zu,%zu,%f\n", i, i % 97, lines - i, i / 8.0);
+
+        TEST_ASSERT_NOT_NULL(fgets(buffer, sizeof(buffer), outfile));
+        TEST_ASSERT_EQUAL_STRING(expected, buffer);
+    }
+    TEST_ASSERT_NOT_NULL(fgets(buffer, sizeof(buffer), outfile));
+    TEST_ASSERT_EQUAL_STRING("tail\n", buffer);
+
+    for (size_t i = 0; i < lines; i++)
+        free(records[i].field_str);
+    free(records);
+    fclose(infile);
+    fclose(outfile);
+}
+
+static void records_gzip_round_trip() {
+    // several ring blocks of lines, so that some straddle two blocks
+    const size_t lines = 2 * GZIP_RING_BLOCKS * GZIP_BLOCK_BYTES / 24;
+    Record *records = malloc(lines * sizeof(Record));
+    TEST_ASSERT_NOT_NULL(records);
+    for (size_t i = 0; i < lines; i++)
+        records[i] = (Record){ (int)i, i % 2 ? "odd" : "even", (int)(lines - i), i / 4.0 };
+
+    FILE *file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    save_records_gzip(file, records, lines);
+    rewind(file);
+
+    TEST_ASSERT_TRUE(gzip_detect(file));
+    size_t count;
+    Record *loaded = read_records(file, &count);
+
+    TEST_ASSERT_EQUAL_INT(lines, count);
+    for (size_t i = 0; i < lines; i++) {
+        TEST_ASSERT_EQUAL_INT(records[i].id, loaded[i].id);
+        TEST_ASSERT_EQUAL_STRING(records[i].field_str, loaded[i].field_str);
+        TEST_ASSERT_EQUAL_INT(records[i].field_int, loaded[i].field_int);
+        TEST_ASSERT_TRUE(records[i].field_fp == loaded[i].field_fp);
+        free(loaded[i].field_str);
+    }
+
+    free(loaded);
+    free(records);
+    fclose(file);
+}
+
+static void format_fixed_matches_printf() {
+    // ties between two millionths round half to even; large values go through snprintf
+    double values[] = { 0.0, -0.0, 1.0 / 128, -1.0 / 128, 0.0000005, 1.0000005, 2.5e-7, -1e-9,
+                        0.1, 2.0 / 3, 123456.1234565, 9999999999999.99, 1e13, -1e300, 5e-324 };
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        char expected[512];
+        char actual[512];
+
+        snprintf(expected, sizeof(expected), "%f", values[i]);
+        *format_fixed(actual, values[i]) = '\0';
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+}
+
+static void save_records_same_output_for_any_thread_count() {
+    const size_t lines = 2 * SAVE_SLICE_LINES + 77;
+    const size_t stride = 1000;
+    Record *records = malloc(lines * sizeof(Record));
+    uint64_t *offsets = malloc(((lines + stride - 1) / stride) * sizeof(uint64_t));
+    TEST_ASSERT_NOT_NULL(records);
+    TEST_ASSERT_NOT_NULL(offsets);
+    for (size_t i = 0; i < lines; i++)
+        records[i] = (Record){ (int)i - 5, i % 3 ? "abc" : "", -(int)i, i * -0.37 };
+
+    FILE *files[3];
+    size_t threads[3] = { 1, 2, 5 };
+    for (size_t f = 0; f < 3; f++) {
+        files[f] = tmpfile();
+        TEST_ASSERT_NOT_NULL(files[f]);
+        fputs("header\n", files[f]);
+
+        LineSink sink = { .file = files[f] };
+        save_formatted(&sink, records, lines, stride, offsets, 7, threads[f]);
+        fflush(files[f]);
+
+        for (size_t j = 0; j * stride < lines; j++) {
+            char buffer[BUFSIZ];
+            char expected[BUFSIZ];
+            const Record *record = &records[j * stride];
+
+            snprintf(expected, sizeof(expected), "%d,%s,%d,%f\n", record->id, record->field_str, record->field_int, record->field_fp);
+            TEST_ASSERT_EQUAL_INT(0, fseeko(files[f], offsets[j], SEEK_SET));
+            TEST_ASSERT_NOT_NULL(fgets(buffer, sizeof(buffer), files[f]));
+            TEST_ASSERT_EQUAL_STRING(expected, buffer);
+        }
+        rewind(files[f]);
+    }
+
+    int a;
+    while ((a = fgetc(files[0])) != EOF) {
+        TEST_ASSERT_EQUAL_INT(a, fgetc(files[1]));
+        TEST_ASSERT_EQUAL_INT(a, fgetc(files[2]));
+    }
+    TEST_ASSERT_EQUAL_INT(EOF, fgetc(files[1]));
+    TEST_ASSERT_EQUAL_INT(EOF, fgetc(files[2]));
+
+    for (size_t f = 0; f < 3; f++)
+        fclose(files[f]);
+    free(offsets);
+    free(records);
+}
+
+static void save_records_small_batch_on_calling_thread() {
+    Record records[] = { { 3, "x", 1, 0.5 }, { -1, "", 22, -2.0 }, { 7, "yy", -3, 1e-7 }, { 0, "z", 0, 4.0 } };
+    uint64_t offsets[2];
+    FILE *file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("header\n", file);
+
+    LineSink sink = { .file = file };
+    save_formatted(&sink, records, 0, 0, NULL, 7, 4);
+    save_formatted(&sink, records, 4, 3, offsets, 7, 4);
+    rewind(file);
+
+    char buffer[256];
+    size_t len = fread(buffer, 1, sizeof(buffer) - 1, file);
+    buffer[len] = '\0';
+    TEST_ASSERT_EQUAL_STRING("header\n3,x,1,0.500000\n-1,,22,-2.000000\n7,yy,-3,0.000000\n0,z,0,4.000000\n", buffer);
+    TEST_ASSERT_EQUAL_INT(7, offsets[0]);
+    TEST_ASSERT_EQUAL_INT(56, offsets[1]);
+
+    fclose(file);
+}
+
+// pipeline tests
+static void pipeline_sort_several_runs_is_stable() {
+    const size_t lines = 3 * PIPELINE_RUN_LINES + 123;
+    FILE *infile = tmpfile();
+    FILE *outfile = tmpfile();
+    TEST_ASSERT_NOT_NULL(infile);
+    TEST_ASSERT_NOT_NULL(outfile);
+
+    for (size_t i = 0; i < lines; i++)
+        fprintf(infile, "%zu,k%zu,%zu,%f\n", i, i % 10, (i * 7919) % 1000, i / 4.0);
+    rewind(infile);
+
+    pipeline_sort(infile, outfile, 2, 1);
+    rewind(outfile);
+
+    char buffer[BUFSIZ];
+    Record previous = { -1, NULL, -1, 0.0 };
+    size_t count = 0;
+    while (fgets(buffer, sizeof(buffer), outfile)) {
+        Record record;
+        parse_record(buffer, &record);
+
+        TEST_ASSERT_TRUE(record.field_int > previous.field_int
+                         || (record.field_int == previous.field_int && record.id > previous.id));
+        free(record.field_str);
+        previous = record;
+        count++;
+    }
+    TEST_ASSERT_EQUAL_INT(lines, count);
+
+    fclose(infile);
+    fclose(outfile);
+}
+
+// batch tests
+static void sort_records_batch_matches_sort_records() {
+    const size_t lines = 2000;
+    FILE *infile = tmpfile();
+    TEST_ASSERT_NOT_NULL(infile);
+
+    for (size_t i = 0; i < lines; i++)
+        fprintf(infile, "%zu,b%zu,%zu,%f\n", i, (i * 13) % 17, (i * 7919) % 100, (i % 9) / 4.0);
+
+    size_t fields[] = { 2, 1 };
+    FILE *outfiles[2];
+    for (size_t f = 0; f < 2; f++) {
+        outfiles[f] = tmpfile();
+        TEST_ASSERT_NOT_NULL(outfiles[f]);
+    }
+    rewind(infile);
+    sort_records_batch(infile, fields, outfiles, 2, 1);
+
+    for (size_t f = 0; f < 2; f++) {
+        FILE *expected = tmpfile();
+        TEST_ASSERT_NOT_NULL(expected);
+        rewind(infile);
+        sort_records_reference(infile, expected, fields[f]);
+
+        assert_same_contents(expected, outfiles[f]);
+        fclose(expected);
+        fclose(outfiles[f]);
+    }
+
+    fclose(infile);
+}
+
+// merge tests
+static void merge_records_into_matches_stable_sort() {
+    // the delta shares keys with the sorted file, so ties decide the order
+    const char *existing = "1,kiwi,30,0.5\n2,apple,10,2.25\n3,fig,20,-1\n4,apple,20,0.5\n5,pear,40,3\n";
+    const char *deltas[] = { "9,fig,20,0.5\n8,banana,5,7\n7,apple,10,-1\n6,zucchini,50,0.5\n", "" };
+    size_t fields[] = { 1, 2, 3 };
+
+    for (size_t f = 0; f < 3; f++) {
+        for (size_t d = 0; d < 2; d++) {
+            FILE *unsorted = tmpfile();
+            FILE *sorted = tmpfile();
+            FILE *delta = tmpfile();
+            FILE *combined = tmpfile();
+            FILE *expected = tmpfile();
+            FILE *outfile = tmpfile();
+            TEST_ASSERT_NOT_NULL(unsorted);
+            TEST_ASSERT_NOT_NULL(sorted);
+            TEST_ASSERT_NOT_NULL(delta);
+            TEST_ASSERT_NOT_NULL(combined);
+            TEST_ASSERT_NOT_NULL(expected);
+            TEST_ASSERT_NOT_NULL(outfile);
+
+            fputs(existing, unsorted);
+            rewind(unsorted);
+            sort_records_reference(unsorted, sorted, fields[f]);
+
+            // existing lines first, so a stable sort keeps them before equal delta records
+            rewind(sorted);
+            int c;
+            while ((c = fgetc(sorted)) != EOF)
+                fputc(c, combined);
+            fputs(deltas[d], combined);
+            rewind(combined);
+            sort_records_reference(combined, expected, fields[f]);
+
+            fputs(deltas[d], delta);
+            rewind(delta);
+            rewind(sorted);
+            merge_records_into(sorted, delta, outfile, fields[f], 2);
+            assert_same_contents(expected, outfile);
+
+            fclose(unsorted);
+            fclose(sorted);
+            fclose(delta);
+            fclose(combined);
+            fclose(expected);
+            fclose(outfile);
+        }
+    }
+}
+
+// distributed sort tests
+static void distributed_sort_matches_sort_records() {
+    // few distinct keys, so that runs of equal keys straddle the splitters
+    const size_t lines = 3000;
+    char path[] = "/tmp/test_ex1_XXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    FILE *infile = fdopen(fd, "w+");
+    TEST_ASSERT_NOT_NULL(infile);
+
+    for (size_t i = 0; i < lines; i++)
+        fprintf(infile, "%zu,s%zu,%zu,%f\n", i, (i * 31) % 5, (i * 7) % 4, (i % 3) / 2.0);
+    fflush(infile);
+
+    size_t fields[] = { 1, 2, 3 };
+    for (size_t f = 0; f < 3; f++) {
+        FILE *expected = tmpfile();
+        TEST_ASSERT_NOT_NULL(expected);
+        rewind(infile);
+        sort_records_reference(infile, expected, fields[f]);
+
+        for (size_t workers = 2; workers <= 3; workers++) {
+            FILE *outfile = tmpfile();
+            TEST_ASSERT_NOT_NULL(outfile);
+
+            distributed_sort(path, outfile, fields[f], 1, workers);
+            assert_same_contents(expected, outfile);
+            fclose(outfile);
+        }
+        fclose(expected);
+    }
+
+    fclose(infile);
+    unlink(path);
+}
+
+// projection tests
+static void sort_records_projected_copies_lines_verbatim() {
+    const char *input = "1,pear,30,2.5\n2,apple,10,-1\n3,pea,20,7.25\n4,apple,5,0.125";
+    const char *by_string = "2,apple,10,-1\n4,apple,5,0.125\n3,pea,20,7.25\n1,pear,30,2.5\n";
+    const char *by_float = "2,apple,10,-1\n4,apple,5,0.125\n1,pear,30,2.5\n3,pea,20,7.25\n";
+    const char *expected[] = { by_string, by_float };
+    size_t fields[] = { 1, 3 };
+
+    for (size_t t = 0; t < 2; t++) {
+        FILE *infile = tmpfile();
+        FILE *outfile = tmpfile();
+        TEST_ASSERT_NOT_NULL(infile);
+        TEST_ASSERT_NOT_NULL(outfile);
+        fputs(input, infile);
+        fflush(infile);
+
+        sort_records_projected(infile, outfile, fields[t], 1);
+        rewind(outfile);
+
+        char buffer[256];
+        size_t len = fread(buffer, 1, sizeof(buffer) - 1, outfile);
+        buffer[len] = '\0';
+        TEST_ASSERT_EQUAL_STRING(expected[t], buffer);
+
+        fclose(infile);
+        fclose(outfile);
+    }
+}
+
+// instrumentation tests
+static void stats_print_json_reports_phases() {
+    int array[] = {5, 3, 9, 1, 7, 2, 8};
+    char buffer[1024];
+
+    stats_enable();
+    sort_with_algorithm(array, 7, sizeof(int), 2, compare_int, 2);
+
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    stats_print_json(out);
+    rewind(out);
+    size_t len = fread(buffer, 1, sizeof(buffer) - 1, out);
+    buffer[len] = '\0';
+    fclose(out);
+
+    TEST_ASSERT_EQUAL_INT('{', buffer[0]);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"sort\":{\"calls\":1,"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"peak_rss_kb\":"));
+#ifdef SORT_STATS
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"comparisons\":"));
+    TEST_ASSERT_NULL(strstr(buffer, "\"comparisons\":0,"));
+    TEST_ASSERT_NULL(strstr(buffer, "\"max_recursion_depth\":0,"));
+#else
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"counters\":null"));
+#endif
+}
+
+// sparse index tests
+static void sparse_index_seek_int() {
+    Record records[10];
+    uint64_t offsets[4];
+
+    // keys 0, 0, 2, 2, 4, 4, ... every line 10 bytes long, one key sampled every 3 lines
+    for (size_t i = 0; i < 10; i++)
+        records[i] = (Record){ (int)i, "x", (int)(i / 2 * 2), 0.0 };
+    for (size_t j = 0; j < 4; j++)
+        offsets[j] = j * 30;
+
+    SparseIndex *index = sparse_index_build(records, 10, 2, 3, offsets);
+    TEST_ASSERT_EQUAL_INT(4, index->header.count);
+
+    // sampled keys: 0 (offset 0), 2 (30), 6 (60), 8 (90)
+    SparseIndexKey key = sparse_index_parse_key(index, "-1");
+    TEST_ASSERT_EQUAL_INT(0, sparse_index_seek(index, &key));
+    key = sparse_index_parse_key(index, "2");
+    TEST_ASSERT_EQUAL_INT(0, sparse_index_seek(index, &key));
+    key = sparse_index_parse_key(index, "5");
+    TEST_ASSERT_EQUAL_INT(30, sparse_index_seek(index, &key));
+    key = sparse_index_parse_key(index, "8");
+    TEST_ASSERT_EQUAL_INT(60, sparse_index_seek(index, &key));
+    key = sparse_index_parse_key(index, "100");
+    TEST_ASSERT_EQUAL_INT(90, sparse_index_seek(index, &key));
+
+    sparse_index_free(index);
+}
+
+static void sparse_index_seek_string() {
+    char *words[] = {"apple", "banana", "cherry", "date", "elderberry", "fig", "grape"};
+    Record records[7];
+    uint64_t offsets[7];
+
+    for (size_t i = 0; i < 7; i++) {
+        records[i] = (Record){ (int)i, words[i], 0, 0.0 };
+        offsets[i] = i * 100;
+    }
+
+    SparseIndex *index = sparse_index_build(records, 7, 1, 1, offsets);
+
+    SparseIndexKey key = sparse_index_parse_key(index, "cherry");
+    TEST_ASSERT_EQUAL_INT(100, sparse_index_seek(index, &key));
+    key = sparse_index_parse_key(index, "dog");
+    TEST_ASSERT_EQUAL_INT(300, sparse_index_seek(index, &key));
+    key = sparse_index_parse_key(index, "zucchini");
+    TEST_ASSERT_EQUAL_INT(600, sparse_index_seek(index, &key));
+
+    TEST_ASSERT_TRUE(sparse_index_compare_line(index, "3,dog,1,1.0\n", &key) < 0);
+    TEST_ASSERT_TRUE(sparse_index_compare_line(index, "3,zucchini,1,1.0\n", &key) == 0);
+
+    sparse_index_free(index);
+}
+
 int main(int argc, char *argv[]) {
     
     UNITY_BEGIN();
@@ -308,6 +1011,10 @@ int main(int argc, char *argv[]) {
     RUN_TEST(test_partition_float);
     RUN_TEST(test_partition_string);
 
+    RUN_TEST(test_block_partition_int);
+    RUN_TEST(test_block_partition_large_int);
+    RUN_TEST(test_block_partition_large_string);
+
     RUN_TEST(quick_sort_worst_case_int);
     RUN_TEST(quick_sort_worst_case_float);
     RUN_TEST(quick_sort_worst_case_string);
@@ -319,6 +1026,41 @@ int main(int argc, char *argv[]) {
     RUN_TEST(quick_sort_duplicate_elements_int);
     RUN_TEST(quick_sort_duplicate_elements_float);
     RUN_TEST(quick_sort_duplicate_elements_string);
+    RUN_TEST(quick_sort_large_random_int);
+
+    RUN_TEST(multiway_merge_sort_medium_case_int);
+    RUN_TEST(multiway_merge_sort_duplicate_elements_float);
+    RUN_TEST(multiway_merge_sort_medium_case_string);
+    RUN_TEST(multiway_merge_sort_large_input_is_stable);
+
+    RUN_TEST(inplace_merge_sort_medium_case_int);
+    RUN_TEST(inplace_merge_sort_duplicate_elements_string);
+    RUN_TEST(inplace_merge_sort_large_input_is_stable);
+    RUN_TEST(inplace_merge_sort_without_buffer_is_stable);
+
+    RUN_TEST(records_round_trip_across_chunks);
+    RUN_TEST(records_gzip_round_trip);
+    RUN_TEST(format_fixed_matches_printf);
+    RUN_TEST(save_records_same_output_for_any_thread_count);
+    RUN_TEST(save_records_small_batch_on_calling_thread);
+
+    RUN_TEST(pipeline_sort_several_runs_is_stable);
+
+    RUN_TEST(sort_records_batch_matches_sort_records);
+    RUN_TEST(merge_records_into_matches_stable_sort);
+    RUN_TEST(distributed_sort_matches_sort_records);
+
+    RUN_TEST(sort_records_projected_copies_lines_verbatim);
+
+    RUN_TEST(stats_print_json_reports_phases);
+
+    RUN_TEST(sparse_index_seek_int);
+    RUN_TEST(sparse_index_seek_string);
+
+    RUN_TEST(sort_probe_sorted_int);
+    RUN_TEST(sort_probe_reversed_float);
+    RUN_TEST(sort_probe_duplicate_elements_string);
+    RUN_TEST(sort_probe_large_input_is_sampled);
 
     return UNITY_END();
 }
\ No newline at end of file
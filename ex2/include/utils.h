@@ -1,8 +1,12 @@
+#ifndef UTILS_H
+#define UTILS_H
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <ctype.h>
+#include <stdint.h>
 
 #define GENERIC_ERROR(message)                                        \
     do {                                                              \
@@ -10,5 +14,202 @@
         exit(EXIT_FAILURE);                                           \
     } while(0)
 
+/**
+ * Scratch rows reused by the dynamic programming edit distance, grown on demand.
+ */
+typedef struct {
+    int *rows;
+    size_t cap;     // capacity of rows, in ints
+} EditWorkspace;
+
+// stages of the signature filter, in the order they are tried
+#define SIGNATURE_LENGTH 0
+#define SIGNATURE_MASK 1
+#define SIGNATURE_COUNTS 2
+#define SIGNATURE_STAGES 3
+
+/**
+ * Summary of a word for the signature filter: length, letters a to z held (bit i for
+ * letter i) and their counts, 4 bits each, saturated at 15 (letters a-m in counts[0]).
+ */
+typedef struct {
+    uint32_t length;
+    uint32_t mask;
+    uint64_t counts[2];
+} WordSignature;
+
+/**
+ * Dictionary words at minimum edit distance from a query, by position in the dictionary.
+ */
+typedef struct {
+    int distance;       // INT_MAX until a word is offered
+    uint32_t *ids;
+    size_t count;
+    size_t cap;
+    size_t examined;    // words whose distance was computed
+    size_t rejected[SIGNATURE_STAGES];  // words rejected by each stage of the signature filter
+} Corrections;
+
+/**
+ * Dictionary words grouped by length: bucket len holds words[start[len]] up to
+ * words[start[len + 1]], in dictionary order, and ids gives their positions.
+ * signatures, when not NULL, holds the signature of each word by position.
+ */
+typedef struct {
+    char **words;
+    const WordSignature *signatures;
+    uint32_t *ids;
+    size_t *start;
+    size_t max_len;
+    size_t count;
+} LengthIndex;
+
+/**
+ * Edge of a BK-tree: the subtree rooted at child holds words at the given distance
+ * from the parent node.
+ */
+typedef struct {
+    uint32_t child;
+    uint32_t distance;
+} BkEdge;
+
+/**
+ * Burkhard-Keller tree over a dictionary, stored as flat arrays: node i is word i, and
+ * its edges are edges[first[i]] up to edges[first[i + 1]], sorted by distance.
+ */
+typedef struct {
+    char **words;
+    size_t count;
+    uint32_t *first;
+    BkEdge *edges;
+} BkTree;
+
+/**
+ * Node of a trie: label is the character of the edge from the parent, word the position
+ * of the first dictionary word ending here. Links are indices into the arena.
+ */
+typedef struct {
+    uint32_t first_child;
+    uint32_t next_sibling;
+    uint32_t word;
+    unsigned char label;
+} TrieNode;
+
+/**
+ * Trie over a dictionary, all nodes in one arena with the root at index 0; next_word
+ * chains the positions of repeated words.
+ */
+typedef struct {
+    TrieNode *nodes;
+    uint32_t *next_word;
+    size_t count;
+    size_t cap;
+    size_t max_depth;
+} Trie;
+
+// largest number of deletions per word a deletion index accepts
+#define DELETION_MAX_DEPTH 4
+
+/**
+ * Deletion variants of the dictionary words in an open addressing table of mask + 1
+ * slots: slot i maps a variant, known by 32 bits of its hash (fingerprints[i]), to the
+ * position of one word it comes from (ids[i], UINT32_MAX when the slot is empty).
+ * signatures, when not NULL, holds the signature of each word by position.
+ */
+typedef struct {
+    char **words;
+    const WordSignature *signatures;
+    size_t count;
+    uint32_t *ids;
+    uint32_t *fingerprints;
+    size_t mask;
+    size_t entries;
+    int max_depth;
+} DeletionIndex;
+
+/**
+ * Inverted index from the padded q-grams of the dictionary words to their positions:
+ * the gram keys[i] has its posting list in postings[begin[i]] up to postings[end[i]],
+ * as LEB128 deltas. lengths groups the words by length, and signatures, when not NULL,
+ * holds the signature of each word by position.
+ */
+typedef struct {
+    char **words;
+    const WordSignature *signatures;
+    size_t count;
+    int q;
+    uint32_t *keys;
+    size_t *begin;
+    size_t *end;
+    size_t mask;
+    size_t distinct;
+    uint8_t *postings;
+    LengthIndex *lengths;
+} QgramIndex;
+
+// largest distance an indel automaton accepts, and the state of the empty input
+#define AUTOMATON_MAX_DISTANCE 3
+#define AUTOMATON_START 1
+
+/**
+ * Deterministic automaton accepting the strings within indel distance k of a word of
+ * length characters. State s is the row rows[s * (length + 1)] of the edit distance
+ * table, cells clipped to k + 1, and moves on a character c to
+ * next[s * classes + class_of[c]]; slots finds a state from its row.
+ */
+typedef struct {
+    size_t length;
+    int k;
+    uint8_t class_of[256];
+    size_t classes;
+    uint8_t *rows;
+    uint32_t *next;
+    size_t states;
+    size_t cap;
+    uint32_t *slots;
+    size_t slot_mask;
+} IndelAutomaton;
+
 extern int edit_distance(const char *s1, const char* s2);
-extern int edit_distance_dyn(const char *s1, const char* s2);
\ No newline at end of file
+extern int edit_distance_dyn(const char *s1, const char* s2);
+extern int edit_distance_dyn_ws(const char *s1, const char *s2, EditWorkspace *ws);
+extern void edit_workspace_free(EditWorkspace *ws);
+extern int edit_distance_bitpar(const char *s1, const char *s2);
+extern int edit_distance_bounded(const char *s1, const char *s2, int k);
+extern int edit_distance_bounded_ws(const char *s1, const char *s2, int k, EditWorkspace *ws);
+
+extern void corrections_clear(Corrections *corrections);
+extern void corrections_offer(Corrections *corrections, uint32_t id, int distance);
+extern void corrections_finish(Corrections *corrections);
+extern void corrections_free(Corrections *corrections);
+
+extern void signature_compute(const char *word, WordSignature *signature);
+extern int signature_filter(const WordSignature *a, const WordSignature *b, int bound, size_t *rejected);
+
+extern LengthIndex *length_index_build(char **dictionary, const WordSignature *signatures, size_t lines);
+extern void length_index_search(const LengthIndex *index, const char *word, Corrections *corrections);
+extern void length_index_free(LengthIndex *index);
+
+extern BkTree *bk_tree_build(char **dictionary, size_t lines);
+extern void bk_tree_search(const BkTree *tree, const char *word, Corrections *corrections);
+extern void bk_tree_within(const BkTree *tree, const char *word, int k, void (*report)(uint32_t id, int distance, void *arg), void *arg);
+extern void bk_tree_free(BkTree *tree);
+
+extern Trie *trie_build(char **dictionary, size_t lines);
+extern void trie_search(const Trie *trie, const char *word, Corrections *corrections);
+extern void trie_free(Trie *trie);
+
+extern DeletionIndex *deletion_index_build(char **dictionary, const WordSignature *signatures, size_t lines, int max_depth);
+extern void deletion_index_search(const DeletionIndex *index, const char *word, Corrections *corrections);
+extern void deletion_index_free(DeletionIndex *index);
+
+extern QgramIndex *qgram_index_build(char **dictionary, const WordSignature *signatures, size_t lines, int q);
+extern void qgram_index_search(const QgramIndex *index, const char *word, Corrections *corrections);
+extern void qgram_index_free(QgramIndex *index);
+
+extern IndelAutomaton *automaton_build(const char *word, int k);
+extern int automaton_distance(const IndelAutomaton *automaton, const char *s);
+extern void automaton_search(const Trie *trie, const char *word, int k, Corrections *corrections);
+extern void automaton_free(IndelAutomaton *automaton);
+
+#endif
\ No newline at end of file
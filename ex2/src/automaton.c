@@ -0,0 +1,251 @@
+#include "../include/utils.h"
+
+#define AUTOMATON_DEAD 0
+
+// FNV-1a over the cells of a row
+static uint64_t hash_row(const uint8_t *row, size_t width) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+
+    for (size_t i = 0; i < width; i++) {
+        hash ^= row[i];
+        hash *= UINT64_C(1099511628211);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Returns the state whose row is row, adding it if it is new; the table of
+ * states doubles whenever it gets half full.
+ */
+static uint32_t intern_row(IndelAutomaton *automaton, const uint8_t *row) {
+    size_t width = automaton->length + 1;
+
+    if (2 * (automaton->states + 1) > automaton->slot_mask + 1) {
+        size_t slots = 2 * (automaton->slot_mask + 1);
+        uint32_t *table = malloc(slots * sizeof(uint32_t));
+        if (!table)
+            GENERIC_ERROR("malloc: memory allocation failed");
+
+        memset(table, 0xff, slots * sizeof(uint32_t));
+        for (size_t s = 0; s < automaton->states; s++) {
+            size_t slot = hash_row(automaton->rows + s * width, width) & (slots - 1);
+
+            while (table[slot] != UINT32_MAX)
+                slot = (slot + 1) & (slots - 1);
+            table[slot] = (uint32_t)s;
+        }
+
+        free(automaton->slots);
+        automaton->slots = table;
+        automaton->slot_mask = slots - 1;
+    }
+
+    size_t slot = hash_row(row, width) & automaton->slot_mask;
+    for (; automaton->slots[slot] != UINT32_MAX; slot = (slot + 1) & automaton->slot_mask) {
+        uint32_t state = automaton->slots[slot];
+
+        if (memcmp(automaton->rows + state * width, row, width) == 0)
+            return state;
+    }
+
+    if (automaton->states == automaton->cap) {
+        automaton->cap = automaton->cap ? automaton->cap * 2 : 64;
+        automaton->rows = realloc(automaton->rows, automaton->cap * width);
+        automaton->next = realloc(automaton->next, automaton->cap * automaton->classes * sizeof(uint32_t));
+        if (!automaton->rows || !automaton->next)
+            GENERIC_ERROR("realloc: memory allocation failed");
+    }
+
+    uint32_t state = (uint32_t)automaton->states++;
+    memcpy(automaton->rows + state * width, row, width);
+    automaton->slots[slot] = state;
+
+    return state;
+}
+
+/**
+ * @brief Builds the deterministic automaton accepting the strings within indel distance k
+ * of a word.
+ * 
+ * A state is a row of the edit distance table between the word and the input read so
+ * far, with every cell above k clipped to k + 1: two inputs reaching the same row accept
+ * the same suffixes, so the rows are the states of the DFA and the clipping keeps them
+ * finitely many. The characters absent from the word all move the same way, so the
+ * input is mapped to classes first: 0 for those, then one per distinct character of the
+ * word. The states are built breadth first from the row of the empty input, each with
+ * one transition per class; state 0 is the dead one, all k + 1, and loops on itself.
+ * 
+ * @param word The query.
+ * @param k The largest distance accepted, from 0 to AUTOMATON_MAX_DISTANCE.
+ * @return The automaton, to be released with automaton_free().
+ */
+IndelAutomaton *automaton_build(const char *word, int k) {
+    if (!word)
+        GENERIC_ERROR("automaton_build: word not provided");
+    if (k < 0 || k > AUTOMATON_MAX_DISTANCE)
+        GENERIC_ERROR("automaton_build: k out of range");
+
+    IndelAutomaton *automaton = calloc(1, sizeof(IndelAutomaton));
+    if (!automaton)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    const unsigned char *s = (const unsigned char *)word;
+    size_t len = strlen(word);
+    automaton->length = len;
+    automaton->k = k;
+
+    automaton->classes = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (automaton->class_of[s[i]] == 0)
+            automaton->class_of[s[i]] = (uint8_t)automaton->classes++;
+    }
+
+    // a character standing for each class
+    unsigned char symbol[257] = {0};
+    for (size_t c = 0; c < 256; c++)
+        symbol[automaton->class_of[c]] = (unsigned char)c;
+
+    automaton->slots = malloc(16 * sizeof(uint32_t));
+    if (!automaton->slots)
+        GENERIC_ERROR("malloc: memory allocation failed");
+    memset(automaton->slots, 0xff, 16 * sizeof(uint32_t));
+    automaton->slot_mask = 15;
+
+    size_t width = len + 1;
+    uint8_t over = (uint8_t)(k + 1);
+    uint8_t *row = malloc(width);
+    if (!row)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    memset(row, over, width);
+    intern_row(automaton, row);
+    for (size_t j = 0; j <= len; j++)
+        row[j] = j < over ? (uint8_t)j : over;
+    intern_row(automaton, row);
+
+    for (size_t state = 0; state < automaton->states; state++) {
+        for (size_t c = 0; c < automaton->classes; c++) {
+            const uint8_t *prev = automaton->rows + state * width;
+
+            row[0] = prev[0] < over ? prev[0] + 1 : over;
+            for (size_t j = 1; j <= len; j++) {
+                uint8_t d;
+
+                // no edit needed; class 0 matches no character of the word
+                if (c != 0 && s[j - 1] == symbol[c])
+                    d = prev[j - 1];
+                else
+                    d = 1 + (prev[j] < row[j - 1] ? prev[j] : row[j - 1]);
+
+                row[j] = d < over ? d : over;
+            }
+
+            // interning may move the rows, so prev is not used past this point
+            uint32_t next = intern_row(automaton, row);
+            automaton->next[state * automaton->classes + c] = next;
+        }
+    }
+
+    free(row);
+
+    return automaton;
+}
+
+void automaton_free(IndelAutomaton *automaton) {
+    if (!automaton)
+        return ;
+
+    free(automaton->rows);
+    free(automaton->next);
+    free(automaton->slots);
+    free(automaton);
+}
+
+/**
+ * @brief Runs the automaton on a string.
+ * 
+ * @return The indel distance between the string and the word of the automaton if it is
+ *         at most k, k + 1 otherwise.
+ */
+int automaton_distance(const IndelAutomaton *automaton, const char *s) {
+    if (!automaton || !s)
+        GENERIC_ERROR("automaton_distance: arguments not provided");
+
+    uint32_t state = AUTOMATON_START;
+    for (const unsigned char *c = (const unsigned char *)s; *c && state != AUTOMATON_DEAD; c++)
+        state = automaton->next[state * automaton->classes + automaton->class_of[*c]];
+
+    return automaton->rows[state * (automaton->length + 1) + automaton->length];
+}
+
+// trie node waiting on the search stack, with the state reached on its prefix
+typedef struct {
+    uint32_t node;
+    uint32_t state;
+} AutomatonPending;
+
+/**
+ * @brief Finds the dictionary words at minimum edit distance from a word, if it is at most k.
+ * 
+ * The automaton of the word is walked in lockstep with the trie of the dictionary: each
+ * node gets the state reached on its prefix with one table lookup, and a node whose state
+ * is dead is skipped with its whole subtree, since no word below it can be within k.
+ * 
+ * @param trie The trie of the dictionary.
+ * @param word The word to correct.
+ * @param k The largest distance of interest, from 0 to AUTOMATON_MAX_DISTANCE.
+ * @param corrections Receives the minimum distance and the positions of the words at
+ *                    that distance, in dictionary order; no word at all when every word
+ *                    is farther than k. examined counts the trie nodes visited.
+ */
+void automaton_search(const Trie *trie, const char *word, int k, Corrections *corrections) {
+    if (!trie || !word || !corrections)
+        GENERIC_ERROR("automaton_search: arguments not provided");
+
+    corrections_clear(corrections);
+
+    IndelAutomaton *automaton = automaton_build(word, k);
+    size_t width = automaton->length + 1;
+    AutomatonPending *stack = NULL;
+    size_t count = 0, cap = 0;
+
+    if (trie->count > 0) {
+        stack = malloc(sizeof(AutomatonPending));
+        if (!stack)
+            GENERIC_ERROR("malloc: memory allocation failed");
+        stack[count++] = (AutomatonPending){ 0, AUTOMATON_START };
+        cap = 1;
+    }
+
+    while (count > 0) {
+        AutomatonPending pending = stack[--count];
+        int distance = automaton->rows[pending.state * width + automaton->length];
+
+        corrections->examined++;
+        if (distance <= k) {
+            for (uint32_t id = trie->nodes[pending.node].word; id != UINT32_MAX; id = trie->next_word[id])
+                corrections_offer(corrections, id, distance);
+        }
+
+        for (uint32_t child = trie->nodes[pending.node].first_child; child != UINT32_MAX; child = trie->nodes[child].next_sibling) {
+            uint32_t state = automaton->next[pending.state * automaton->classes + automaton->class_of[trie->nodes[child].label]];
+
+            if (state == AUTOMATON_DEAD)
+                continue;
+
+            if (count == cap) {
+                cap *= 2;
+                stack = realloc(stack, cap * sizeof(AutomatonPending));
+                if (!stack)
+                    GENERIC_ERROR("realloc: memory allocation failed");
+            }
+            stack[count++] = (AutomatonPending){ child, state };
+        }
+    }
+
+    free(stack);
+    automaton_free(automaton);
+
+    corrections_finish(corrections);
+}
@@ -0,0 +1,211 @@
+#include "../include/utils.h"
+
+#define BK_NONE UINT32_MAX
+
+/**
+ * Edge list used while building: the edges of a node are chained through next,
+ * all of them in one growable pool.
+ */
+typedef struct {
+    uint32_t child;
+    uint32_t distance;
+    uint32_t next;
+} BkBuildEdge;
+
+// node waiting on the search stack, with the lower bound of the distance of its subtree words
+typedef struct {
+    uint32_t node;
+    uint32_t bound;
+} BkPending;
+
+static int compare_edge(const void *a, const void *b) {
+    const BkEdge *x = a;
+    const BkEdge *y = b;
+
+    return (x->distance > y->distance) - (x->distance < y->distance);
+}
+
+/**
+ * @brief Builds a Burkhard-Keller tree over the words of a dictionary.
+ * 
+ * Word i is node i and word 0 is the root. Each word is inserted by walking down from
+ * the root, following at every node the edge labelled with the distance between the
+ * word and the node, until a node has no such edge. Duplicated words hang below their
+ * first occurrence on an edge labelled 0. The edges are then laid out contiguously per
+ * node and sorted by distance (first[i] up to first[i + 1]), so that the tree is three
+ * flat arrays.
+ * 
+ * @param dictionary An array of dictionary words.
+ * @param lines The number of words in the dictionary.
+ * @return The tree, to be released with bk_tree_free().
+ */
+BkTree *bk_tree_build(char **dictionary, size_t lines) {
+    if (!dictionary && lines > 0)
+        GENERIC_ERROR("bk_tree_build: dictionary not provided");
+    if (lines >= BK_NONE)
+        GENERIC_ERROR("bk_tree_build: too many words");
+
+    BkTree *tree = calloc(1, sizeof(BkTree));
+    if (!tree)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    tree->words = dictionary;
+    tree->count = lines;
+    tree->first = calloc(lines + 1, sizeof(uint32_t));
+    tree->edges = malloc((lines ? lines : 1) * sizeof(BkEdge));
+
+    // every word but the root is the child of exactly one edge
+    uint32_t *head = malloc((lines ? lines : 1) * sizeof(uint32_t));
+    BkBuildEdge *pool = malloc((lines ? lines : 1) * sizeof(BkBuildEdge));
+    if (!tree->first || !tree->edges || !head || !pool)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t i = 0; i < lines; i++)
+        head[i] = BK_NONE;
+
+    size_t used = 0;
+    for (size_t i = 1; i < lines; i++) {
+        uint32_t node = 0;
+
+        for (;;) {
+            uint32_t distance = (uint32_t)edit_distance_bitpar(dictionary[i], dictionary[node]);
+            uint32_t edge = head[node];
+
+            while (edge != BK_NONE && pool[edge].distance != distance)
+                edge = pool[edge].next;
+
+            if (edge == BK_NONE) {
+                pool[used] = (BkBuildEdge){ (uint32_t)i, distance, head[node] };
+                head[node] = (uint32_t)used++;
+                tree->first[node + 1]++;
+                break;
+            }
+            node = pool[edge].child;
+        }
+    }
+
+    for (size_t i = 0; i < lines; i++)
+        tree->first[i + 1] += tree->first[i];
+
+    for (size_t i = 0; i < lines; i++) {
+        BkEdge *edges = &tree->edges[tree->first[i]];
+        size_t n = 0;
+
+        for (uint32_t edge = head[i]; edge != BK_NONE; edge = pool[edge].next)
+            edges[n++] = (BkEdge){ pool[edge].child, pool[edge].distance };
+        qsort(edges, n, sizeof(BkEdge), compare_edge);
+    }
+
+    free(head);
+    free(pool);
+
+    return tree;
+}
+
+void bk_tree_free(BkTree *tree) {
+    if (!tree)
+        return ;
+
+    free(tree->first);
+    free(tree->edges);
+    free(tree);
+}
+
+static void push_pending(BkPending **stack, size_t *count, size_t *cap, uint32_t node, uint32_t bound) {
+    if (*count == *cap) {
+        *cap = *cap ? *cap * 2 : 64;
+        *stack = realloc(*stack, *cap * sizeof(BkPending));
+        if (!*stack)
+            GENERIC_ERROR("realloc: memory allocation failed");
+    }
+
+    (*stack)[(*count)++] = (BkPending){ node, bound };
+}
+
+/**
+ * @brief Walks the tree from the root, visiting only the subtrees that can hold words
+ * within the search radius: k, or the best distance found so far when looking for
+ * the nearest words.
+ * 
+ * By the triangle inequality, the words below the edge labelled e of a node at distance
+ * d from the query are at least |d - e| away from it; the edges of a node are sorted, so
+ * those in [d - radius, d + radius] are found by skipping the ones below d - radius.
+ */
+static void bk_tree_walk(const BkTree *tree, const char *word, int k, Corrections *nearest, void (*report)(uint32_t id, int distance, void *arg), void *arg) {
+    BkPending *stack = NULL;
+    size_t count = 0, cap = 0;
+
+    if (tree->count > 0)
+        push_pending(&stack, &count, &cap, 0, 0);
+
+    while (count > 0) {
+        BkPending pending = stack[--count];
+        int radius = nearest ? nearest->distance : k;
+
+        if ((int64_t)pending.bound > radius)
+            continue;
+
+        int distance = edit_distance_bitpar(word, tree->words[pending.node]);
+        if (nearest) {
+            nearest->examined++;
+            corrections_offer(nearest, pending.node, distance);
+            radius = nearest->distance;
+        } else if (distance <= k) {
+            report(pending.node, distance, arg);
+        }
+
+        int64_t low = (int64_t)distance - radius;
+        int64_t high = (int64_t)distance + radius;
+        const BkEdge *edges = &tree->edges[tree->first[pending.node]];
+        size_t n = tree->first[pending.node + 1] - tree->first[pending.node];
+
+        // pushed from the farthest to the closest label, so the closest is searched first
+        for (size_t e = n; e-- > 0; ) {
+            int64_t label = edges[e].distance;
+
+            if (label > high)
+                continue;
+            if (label < low)
+                break;
+            push_pending(&stack, &count, &cap, edges[e].child, (uint32_t)(label > distance ? label - distance : distance - label));
+        }
+    }
+
+    free(stack);
+}
+
+/**
+ * @brief Reports every dictionary word within distance k of a word.
+ * 
+ * @param tree The BK-tree of the dictionary.
+ * @param word The query.
+ * @param k The largest distance reported.
+ * @param report Called with the position of each word found and its distance.
+ * @param arg Passed to report.
+ */
+void bk_tree_within(const BkTree *tree, const char *word, int k, void (*report)(uint32_t id, int distance, void *arg), void *arg) {
+    if (!tree || !word || !report)
+        GENERIC_ERROR("bk_tree_within: arguments not provided");
+
+    bk_tree_walk(tree, word, k, NULL, report, arg);
+}
+
+/**
+ * @brief Finds the dictionary words at minimum edit distance from a word.
+ * 
+ * The search radius is the best distance found so far, so it shrinks as the walk goes on
+ * and prunes more and more of the tree.
+ * 
+ * @param tree The BK-tree of the dictionary.
+ * @param word The word to correct.
+ * @param corrections Receives the minimum distance and the positions of the words at
+ *                    that distance, in dictionary order.
+ */
+void bk_tree_search(const BkTree *tree, const char *word, Corrections *corrections) {
+    if (!tree || !word || !corrections)
+        GENERIC_ERROR("bk_tree_search: arguments not provided");
+
+    corrections_clear(corrections);
+    bk_tree_walk(tree, word, 0, corrections, NULL, NULL);
+    corrections_finish(corrections);
+}
@@ -0,0 +1,62 @@
+#include "../include/utils.h"
+
+/**
+ * @brief Empties a list of corrections, keeping its storage, before a new query.
+ */
+void corrections_clear(Corrections *corrections) {
+    corrections->distance = INT_MAX;
+    corrections->count = 0;
+    corrections->examined = 0;
+    for (size_t i = 0; i < SIGNATURE_STAGES; i++)
+        corrections->rejected[i] = 0;
+}
+
+/**
+ * @brief Offers a dictionary word at a given distance from the query.
+ * 
+ * Words farther than the current minimum are ignored; a closer word drops the ones
+ * kept so far.
+ * 
+ * @param corrections The list of corrections of the query.
+ * @param id The position of the word in the dictionary.
+ * @param distance The edit distance between the word and the query.
+ */
+void corrections_offer(Corrections *corrections, uint32_t id, int distance) {
+    if (distance > corrections->distance)
+        return ;
+
+    if (distance < corrections->distance) {
+        corrections->distance = distance;
+        corrections->count = 0;
+    }
+
+    if (corrections->count == corrections->cap) {
+        corrections->cap = corrections->cap ? corrections->cap * 2 : 16;
+        corrections->ids = realloc(corrections->ids, corrections->cap * sizeof(uint32_t));
+        if (!corrections->ids)
+            GENERIC_ERROR("realloc: memory allocation failed");
+    }
+
+    corrections->ids[corrections->count++] = id;
+}
+
+static int compare_id(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Puts the corrections back in dictionary order, whatever order the search used.
+ */
+void corrections_finish(Corrections *corrections) {
+    qsort(corrections->ids, corrections->count, sizeof(uint32_t), compare_id);
+}
+
+void corrections_free(Corrections *corrections) {
+    free(corrections->ids);
+    corrections->ids = NULL;
+    corrections->cap = 0;
+    corrections->count = 0;
+}
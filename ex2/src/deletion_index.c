@@ -0,0 +1,269 @@
+#include "../include/utils.h"
+
+#define DELETION_NONE UINT32_MAX
+
+// FNV-1a, 64 bits
+static uint64_t hash_variant(const char *variant, size_t len) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)variant[i];
+        hash *= UINT64_C(1099511628211);
+    }
+
+    return hash;
+}
+
+// number of ways to delete up to depth characters out of len, an upper bound of the variants
+static size_t count_variants(size_t len, int depth) {
+    size_t total = 0, ways = 1;
+
+    for (int d = 0; d <= depth && (size_t)d <= len; d++) {
+        total += ways;
+        ways = ways * (len - d) / (d + 1);
+    }
+
+    return total;
+}
+
+/**
+ * @brief Calls visit on the word and on every string obtained by deleting up to depth of
+ * its characters.
+ * 
+ * Deletions happen at non-decreasing positions, so each set of deleted positions is
+ * visited once; repeated letters still give the same string more than once. scratch
+ * holds depth strings of len + 1 characters.
+ */
+static void visit_deletions(const char *word, size_t len, size_t from, int depth, char *scratch, void (*visit)(const char *variant, size_t len, void *arg), void *arg) {
+    visit(word, len, arg);
+
+    if (depth == 0)
+        return ;
+
+    for (size_t i = from; i < len; i++) {
+        memcpy(scratch, word, i);
+        memcpy(scratch + i, word + i + 1, len - i - 1);
+        scratch[len - 1] = '\0';
+
+        visit_deletions(scratch, len - 1, i, depth - 1, scratch + len + 1, visit, arg);
+    }
+}
+
+// word being inserted by deletion_index_build
+typedef struct {
+    DeletionIndex *index;
+    uint32_t id;
+} Insertion;
+
+static void insert_variant(const char *variant, size_t len, void *arg) {
+    Insertion *insertion = arg;
+    DeletionIndex *index = insertion->index;
+    uint64_t hash = hash_variant(variant, len);
+    uint32_t fingerprint = (uint32_t)(hash >> 32);
+    size_t slot = hash & index->mask;
+
+    for (; index->ids[slot] != DELETION_NONE; slot = (slot + 1) & index->mask) {
+        // the same variant reached twice through repeated letters
+        if (index->ids[slot] == insertion->id && index->fingerprints[slot] == fingerprint)
+            return ;
+    }
+
+    index->ids[slot] = insertion->id;
+    index->fingerprints[slot] = fingerprint;
+    index->entries++;
+}
+
+/**
+ * @brief Builds the deletion index of a dictionary.
+ * 
+ * With insertions and deletions only, two words are at distance d exactly when d
+ * deletions split between them turn both into their longest common subsequence. Every
+ * string obtained by deleting up to max_depth characters of a word is a key for it in
+ * an open addressing table with linear probing. A slot only keeps the word position and
+ * 32 bits of the key hash, never the string: a collision only adds a candidate that the
+ * search verifies anyway. The table has at least 4/3 as many slots as there are variants.
+ * 
+ * @param dictionary An array of dictionary words.
+ * @param signatures The signatures of the words, by position, or NULL to compute every
+ *                   bounded distance; they must outlive the index.
+ * @param lines The number of words in the dictionary.
+ * @param max_depth The largest number of deletions per word, from 0 to DELETION_MAX_DEPTH.
+ * @return The index, to be released with deletion_index_free().
+ */
+DeletionIndex *deletion_index_build(char **dictionary, const WordSignature *signatures, size_t lines, int max_depth) {
+    if (!dictionary && lines > 0)
+        GENERIC_ERROR("deletion_index_build: dictionary not provided");
+    if (max_depth < 0 || max_depth > DELETION_MAX_DEPTH)
+        GENERIC_ERROR("deletion_index_build: max_depth out of range");
+    if (lines >= DELETION_NONE)
+        GENERIC_ERROR("deletion_index_build: too many words");
+
+    DeletionIndex *index = calloc(1, sizeof(DeletionIndex));
+    if (!index)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    index->words = dictionary;
+    index->signatures = signatures;
+    index->count = lines;
+    index->max_depth = max_depth;
+
+    size_t variants = 0, max_len = 0;
+    for (size_t i = 0; i < lines; i++) {
+        size_t len = strlen(dictionary[i]);
+
+        variants += count_variants(len, max_depth);
+        if (len > max_len)
+            max_len = len;
+    }
+
+    size_t slots = 16;
+    while (slots < variants + variants / 3)
+        slots *= 2;
+    index->mask = slots - 1;
+
+    index->ids = malloc(slots * sizeof(uint32_t));
+    index->fingerprints = malloc(slots * sizeof(uint32_t));
+    char *scratch = malloc((max_depth + 1) * (max_len + 1));
+    if (!index->ids || !index->fingerprints || !scratch)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    memset(index->ids, 0xff, slots * sizeof(uint32_t));
+
+    for (size_t i = 0; i < lines; i++) {
+        Insertion insertion = { index, (uint32_t)i };
+
+        visit_deletions(dictionary[i], strlen(dictionary[i]), 0, max_depth, scratch, insert_variant, &insertion);
+    }
+
+    free(scratch);
+
+    return index;
+}
+
+void deletion_index_free(DeletionIndex *index) {
+    if (!index)
+        return ;
+
+    free(index->ids);
+    free(index->fingerprints);
+    free(index);
+}
+
+// candidates gathered by a search
+typedef struct {
+    const DeletionIndex *index;
+    uint32_t *ids;
+    size_t count;
+    size_t cap;
+} Candidates;
+
+static void lookup_variant(const char *variant, size_t len, void *arg) {
+    Candidates *candidates = arg;
+    const DeletionIndex *index = candidates->index;
+    uint64_t hash = hash_variant(variant, len);
+    uint32_t fingerprint = (uint32_t)(hash >> 32);
+
+    for (size_t slot = hash & index->mask; index->ids[slot] != DELETION_NONE; slot = (slot + 1) & index->mask) {
+        if (index->fingerprints[slot] != fingerprint)
+            continue;
+
+        if (candidates->count == candidates->cap) {
+            candidates->cap = candidates->cap ? candidates->cap * 2 : 64;
+            candidates->ids = realloc(candidates->ids, candidates->cap * sizeof(uint32_t));
+            if (!candidates->ids)
+                GENERIC_ERROR("realloc: memory allocation failed");
+        }
+        candidates->ids[candidates->count++] = index->ids[slot];
+    }
+}
+
+static int compare_candidate(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Offers word id to corrections if it is within the best distance so far; with a
+ * signature, the words it rules out are skipped before any distance.
+ */
+static void verify_word(const DeletionIndex *index, const char *word, const WordSignature *signature, uint32_t id, Corrections *corrections) {
+    int bound = corrections->distance;
+
+    if (signature && !signature_filter(signature, &index->signatures[id], bound, corrections->rejected))
+        return;
+
+    int distance = edit_distance_bounded(word, index->words[id], bound);
+
+    corrections->examined++;
+    if (distance <= bound)
+        corrections_offer(corrections, id, distance);
+}
+
+/**
+ * @brief Finds the dictionary words at minimum edit distance from a word.
+ * 
+ * The deletion variants of the word are looked up in the index, and the words sharing
+ * one of them are verified with the bounded edit distance, in dictionary order. Any word
+ * left out needs more than max_depth deletions on one side, so it is farther than
+ * max_depth: the result is exact whenever the best distance found is within max_depth.
+ * Otherwise, or when no candidate comes up, the whole dictionary is scanned with the
+ * distance bounded by the best candidate. When the index has signatures, each word
+ * first goes through signature_filter() and corrections->rejected counts the words
+ * ruled out by each of its stages.
+ * 
+ * @param index The deletion index of the dictionary.
+ * @param word The word to correct.
+ * @param corrections Receives the minimum distance and the positions of the words at
+ *                    that distance, in dictionary order; examined counts the words verified.
+ */
+void deletion_index_search(const DeletionIndex *index, const char *word, Corrections *corrections) {
+    if (!index || !word || !corrections)
+        GENERIC_ERROR("deletion_index_search: arguments not provided");
+
+    corrections_clear(corrections);
+
+    size_t len = strlen(word);
+    char *scratch = malloc((index->max_depth + 1) * (len + 1));
+    if (!scratch)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    Candidates candidates = { index, NULL, 0, 0 };
+    visit_deletions(word, len, 0, index->max_depth, scratch, lookup_variant, &candidates);
+    free(scratch);
+
+    qsort(candidates.ids, candidates.count, sizeof(uint32_t), compare_candidate);
+
+    WordSignature query;
+    const WordSignature *signature = NULL;
+    if (index->signatures) {
+        signature_compute(word, &query);
+        signature = &query;
+    }
+
+    for (size_t i = 0; i < candidates.count; i++) {
+        if (i > 0 && candidates.ids[i] == candidates.ids[i - 1])
+            continue;
+
+        verify_word(index, word, signature, candidates.ids[i], corrections);
+    }
+    free(candidates.ids);
+
+    if (corrections->distance > index->max_depth) {
+        int bound = corrections->distance;
+        size_t examined = corrections->examined;
+        size_t rejected[SIGNATURE_STAGES];
+
+        memcpy(rejected, corrections->rejected, sizeof(rejected));
+        corrections_clear(corrections);
+        corrections->examined = examined;
+        memcpy(corrections->rejected, rejected, sizeof(rejected));
+        corrections->distance = bound;
+
+        for (size_t i = 0; i < index->count; i++)
+            verify_word(index, word, signature, (uint32_t)i, corrections);
+    }
+
+    corrections_finish(corrections);
+}
@@ -34,108 +34,320 @@ int edit_distance(const char *s1, const char* s2) {
     return min(d_canc, d_ins);
 }
 
+// workspace of edit_distance_dyn, one per thread so that callers need no setup
+static __thread EditWorkspace thread_workspace;
+
 /**
- * @brief Helper function for computing the edit distance using dynamic programming.
+ * @brief Makes sure the workspace holds at least count ints.
+ */
+static void workspace_reserve(EditWorkspace *ws, size_t count) {
+    if (ws->cap >= count)
+        return ;
+
+    size_t cap = ws->cap ? ws->cap : 64;
+    while (cap < count)
+        cap *= 2;
+
+    int *rows = realloc(ws->rows, cap * sizeof(int));
+    if (!rows)
+        GENERIC_ERROR("realloc: memory allocation failed");
+
+    ws->rows = rows;
+    ws->cap = cap;
+}
+
+/**
+ * @brief Computes the edit distance between two strings using dynamic programming,
+ * with the rows kept in a caller-provided workspace.
  * 
  * Base Case: |s1| = 0, then edit_distance_dyn(s1,s2) = |s2|
  *            |s2| = 0, then edit_distance_dyn(s1,s2) = |s1|
- * This function uses memoization to store intermediate results and avoid redundant calculations.
- * It is called by the edit_distance_dyn function.
+ * The table is filled bottom-up, one row per character of the longer string, keeping
+ * only the previous and the current row over the shorter string: memory is
+ * 2 * (min(|s1|, |s2|) + 1) ints and there is no recursion. The workspace only grows,
+ * so reusing it across calls makes them allocation free.
  * 
  * @param s1 The first string.
  * @param s2 The second string.
- * @param len_s1 The length of the first string.
- * @param len_s2 The length of the second string.
- * @param memo The memoization matrix.
+ * @param ws The workspace holding the rows.
  * @return The edit distance between the two strings.
  */
-static int edit_distance_dyn_helper(const char *s1, const char *s2, int len_s1, int len_s2, int **memo) {
-    if(len_s1 == 0 || len_s2 == 0)
-        return len_s1 + len_s2;
+int edit_distance_dyn_ws(const char *s1, const char *s2, EditWorkspace *ws) {
+    if (!s1 || !s2 || !ws)
+        GENERIC_ERROR("edit_distance_dyn_ws: arguments not provided");
 
-    if(memo[len_s1][len_s2] != -1)
-        return memo[len_s1][len_s2];
+    size_t len_s1 = strlen(s1);
+    size_t len_s2 = strlen(s2);
 
-    // no edit needed
-    if (s1[0] == s2[0])
-        return memo[len_s1][len_s2] = edit_distance_dyn_helper(rest(s1), rest(s2), len_s1 - 1, len_s2 - 1, memo);
+    // columns run over the shorter string
+    if (len_s2 > len_s1) {
+        const char *temp = s1;
+        s1 = s2;
+        s2 = temp;
+        len_s1 = len_s2;
+        len_s2 = strlen(s2);
+    }
+
+    if (len_s2 == 0)
+        return len_s1;
 
-    int d_canc = 1 + edit_distance_dyn_helper(s1, rest(s2), len_s1, len_s2 - 1, memo);
-    int d_ins = 1 + edit_distance_dyn_helper(rest(s1), s2,len_s1 - 1, len_s2,  memo);
+    workspace_reserve(ws, 2 * (len_s2 + 1));
+    int *prev = ws->rows;
+    int *curr = ws->rows + len_s2 + 1;
 
-    return memo[len_s1][len_s2] = min(d_canc, d_ins);
+    for (size_t j = 0; j <= len_s2; j++)
+        prev[j] = j;
+
+    for (size_t i = 1; i <= len_s1; i++) {
+        curr[0] = i;
+
+        for (size_t j = 1; j <= len_s2; j++) {
+            // no edit needed
+            if (s1[i - 1] == s2[j - 1])
+                curr[j] = prev[j - 1];
+            else
+                curr[j] = 1 + min(prev[j], curr[j - 1]);
+        }
+
+        int *temp = prev;
+        prev = curr;
+        curr = temp;
+    }
+
+    return prev[len_s2];
 }
 
 /**
- * @brief Computes the edit distance between two strings using dynamic programming.
+ * @brief Computes the edit distance between two strings if it is at most k.
  * 
- * This function initializes the memoization matrix and calls the helper function
- * to compute the edit distance. It then frees the allocated memory.
+ * Since D[i][j] >= |i - j|, only the cells of the diagonal band |i - j| <= k can hold a
+ * value within the bound (Ukkonen), so each row computes at most 2k + 1 cells and the
+ * cells around the band count as k + 1. The values along a row never rise again once
+ * all of them exceed k, so the function stops at the first row whose minimum is above
+ * k. Pairs whose lengths differ by more than k are rejected before any cell is computed.
  * 
  * @param s1 The first string.
  * @param s2 The second string.
- * @return The edit distance between the two strings.
+ * @param k The bound, at least 0.
+ * @param ws The workspace holding the rows.
+ * @return The edit distance if it is at most k, k + 1 otherwise.
  */
-int edit_distance_dyn(const char *s1, const char* s2) {    
-    int len_s1 = strlen(s1);
-    int len_s2 = strlen(s2);
-
-    int **memo = (int **)malloc((len_s1 + 1) * sizeof(int *));
-    for (int i = 0; i <= len_s1; i++) {
-        memo[i] = (int *)malloc((len_s2 + 1) * sizeof(int));
-        memset(memo[i], -1, (len_s2 + 1) * sizeof(int));
+int edit_distance_bounded_ws(const char *s1, const char *s2, int k, EditWorkspace *ws) {
+    if (!s1 || !s2 || !ws)
+        GENERIC_ERROR("edit_distance_bounded_ws: arguments not provided");
+
+    if (k < 0)
+        GENERIC_ERROR("edit_distance_bounded_ws: negative bound");
+
+    size_t len_s1 = strlen(s1);
+    size_t len_s2 = strlen(s2);
+
+    // rows run over the shorter string
+    if (len_s2 > len_s1) {
+        const char *temp = s1;
+        s1 = s2;
+        s2 = temp;
+        size_t len = len_s1;
+        len_s1 = len_s2;
+        len_s2 = len;
     }
 
-    int result = edit_distance_dyn_helper(s1, s2, len_s1, len_s2, memo);
+    if (len_s1 - len_s2 > (size_t)k)
+        return k + 1;
 
-    for (int i = 0; i <= len_s1; i++)
-        free(memo[i]);
-    free(memo);
+    // the distance never exceeds len_s1 + len_s2, so a larger bound changes nothing
+    size_t bound = (size_t)k < len_s1 + len_s2 ? (size_t)k : len_s1 + len_s2;
+    int over = (int)bound + 1;
 
-    return result;
-}
+    workspace_reserve(ws, 2 * (len_s2 + 2));
+    int *prev = ws->rows;
+    int *curr = ws->rows + len_s2 + 2;
+
+    size_t first_hi = bound < len_s2 ? bound : len_s2;
+    for (size_t j = 0; j <= first_hi; j++)
+        prev[j] = j;
+    prev[first_hi + 1] = over;
+
+    for (size_t i = 1; i <= len_s1; i++) {
+        size_t lo = i > bound ? i - bound : 0;
+        size_t hi = i + bound < len_s2 ? i + bound : len_s2;
+        int row_min = over;
+
+        if (lo == 0) {
+            curr[0] = i;
+            row_min = i;
+            lo = 1;
+        } else {
+            curr[lo - 1] = over;
+        }
+
+        for (size_t j = lo; j <= hi; j++) {
+            int d;
 
-// edit distance dynamic programming version (bottom-up)
-/* int edit_distance_dyn(const char *s1, const char *s2) {
-    int len_s1 = strlen(s1);
-    int len_s2 = strlen(s2);
-
-    // Base Case: |s1| = 0, than edit_distance(s1,s2) = |s2|
-    //            |s2| = 0, than edit_distance(s1,s2) = |s1|
-    if(len_s1 == 0 || len_s2 == 0)
-        return len_s1 + len_s2;
-
-    // allocate memory for memoization matrix
-    int **memo = (int **)malloc((len_s1 + 1) * sizeof(int *));
-    for (int i = 0; i <= len_s1; i++)
-        memo[i] = (int *)malloc((len_s2 + 1) * sizeof(int));
-
-    // memo initialization
-    for (int i = 0; i <= len_s1; i++) {
-        for (int j = 0; j <= len_s2; j++) {
-            if (i == 0)
-                memo[i][j] = j;
-            else if (j == 0)
-                memo[i][j] = i;
             // no edit needed
-            else if (s1[i - 1] == s2[j - 1])
-                memo[i][j] = memo[i - 1][j - 1];
-            // characters do not matches
+            if (s1[i - 1] == s2[j - 1])
+                d = prev[j - 1];
             else
-                memo[i][j] = 1 + min(memo[i][j - 1], memo[i - 1][j]);
+                d = 1 + min(prev[j], curr[j - 1]);
+
+            if (d > over)
+                d = over;
+            curr[j] = d;
+            if (d < row_min)
+                row_min = d;
         }
+        curr[hi + 1] = over;
+
+        if (row_min > (int)bound)
+            return k + 1;
+
+        int *temp = prev;
+        prev = curr;
+        curr = temp;
+    }
+
+    return prev[len_s2] <= (int)bound ? prev[len_s2] : k + 1;
+}
+
+/**
+ * @brief Same as edit_distance_bounded_ws() with a workspace private to the calling thread.
+ */
+int edit_distance_bounded(const char *s1, const char *s2, int k) {
+    return edit_distance_bounded_ws(s1, s2, k, &thread_workspace);
+}
+
+/**
+ * @brief Releases the rows of a workspace; it can be reused afterwards.
+ */
+void edit_workspace_free(EditWorkspace *ws) {
+    free(ws->rows);
+    ws->rows = NULL;
+    ws->cap = 0;
+}
+
+/**
+ * @brief Computes the edit distance between two strings using dynamic programming.
+ * 
+ * Same as edit_distance_dyn_ws() with a workspace private to the calling thread,
+ * so repeated calls allocate nothing once the longest string has been seen.
+ * 
+ * @param s1 The first string.
+ * @param s2 The second string.
+ * @return The edit distance between the two strings.
+ */
+int edit_distance_dyn(const char *s1, const char* s2) {
+    return edit_distance_dyn_ws(s1, s2, &thread_workspace);
+}
+
+// match masks of the pattern, one word per 64 characters: peq[c * words + w]
+static __thread uint64_t *thread_peq;
+static __thread size_t thread_peq_words;
+
+/**
+ * @brief Computes the edit distance between two strings with the bit-parallel LCS recurrence.
+ * 
+ * With insertions and deletions only, distance = |s1| + |s2| - 2 * LCS(s1, s2). The LCS is
+ * computed with the Allison-Dix / Hyyro recurrence over the shorter string (the pattern):
+ * bit i of the match mask of a character is set when the pattern has that character at
+ * position i, and each character of the text updates the state vector V with
+ * V = (V + (V & M)) | (V & ~M). Every zero bit of V is then one character of the LCS.
+ * Patterns longer than 64 characters use one 64-bit block per 64 characters, with the
+ * carry of the addition going from each block to the next, for O(ceil(m / 64) * n) word
+ * operations. The match masks are kept in a table private to the calling thread,
+ * whose entries are cleared after use so that no call has to wipe it.
+ * 
+ * @param s1 The first string.
+ * @param s2 The second string.
+ * @return The edit distance between the two strings.
+ */
+int edit_distance_bitpar(const char *s1, const char *s2) {
+    if (!s1 || !s2)
+        GENERIC_ERROR("edit_distance_bitpar: arguments not provided");
+
+    size_t len_s1 = strlen(s1);
+    size_t len_s2 = strlen(s2);
+
+    // the pattern is the shorter string
+    if (len_s1 > len_s2) {
+        const char *temp = s1;
+        s1 = s2;
+        s2 = temp;
+        size_t len = len_s1;
+        len_s1 = len_s2;
+        len_s2 = len;
     }
 
-    // save the result
-    int result = memo[len_s1][len_s2];
+    if (len_s1 == 0)
+        return len_s2;
 
-    // free allocated memory
-    for (int i = 0; i <= len_s1; i++)
-        free(memo[i]);
-    free(memo);
+    const unsigned char *pattern = (const unsigned char *)s1;
+    const unsigned char *text = (const unsigned char *)s2;
+    size_t words = (len_s1 + 63) / 64;
 
-    return result;
+    if (thread_peq_words < words) {
+        free(thread_peq);
+        thread_peq = calloc(256 * words, sizeof(uint64_t));
+        if (!thread_peq)
+            GENERIC_ERROR("calloc: memory allocation failed");
+        thread_peq_words = words;
+    }
+
+    for (size_t i = 0; i < len_s1; i++)
+        thread_peq[pattern[i] * words + i / 64] |= UINT64_C(1) << (i % 64);
+
+    size_t lcs = 0;
+
+    if (words == 1) {
+        uint64_t v = ~UINT64_C(0);
+
+        for (size_t j = 0; j < len_s2; j++) {
+            uint64_t m = thread_peq[text[j]];
+            uint64_t u = v & m;
+
+            v = (v + u) | (v & ~m);
+        }
+
+        uint64_t used = len_s1 == 64 ? ~UINT64_C(0) : (UINT64_C(1) << len_s1) - 1;
+        lcs = __builtin_popcountll(~v & used);
+    } else {
+        uint64_t v_stack[8];
+        uint64_t *v = words <= 8 ? v_stack : malloc(words * sizeof(uint64_t));
+        if (!v)
+            GENERIC_ERROR("malloc: memory allocation failed");
+
+        for (size_t w = 0; w < words; w++)
+            v[w] = ~UINT64_C(0);
+
+        for (size_t j = 0; j < len_s2; j++) {
+            const uint64_t *m = &thread_peq[text[j] * words];
+            uint64_t carry = 0;
+
+            for (size_t w = 0; w < words; w++) {
+                uint64_t u = v[w] & m[w];
+                uint64_t sum = v[w] + u;
+                uint64_t out = sum < v[w];
 
-    // return the edit distance between s1 and s2
-    return memo[len_s1][len_s2];
-} */
\ No newline at end of file
+                sum += carry;
+                out |= sum < carry;
+                carry = out;
+
+                v[w] = sum | (v[w] & ~m[w]);
+            }
+        }
+
+        for (size_t w = 0; w < words; w++) {
+            size_t bits = w + 1 < words ? 64 : len_s1 - w * 64;
+            uint64_t used = bits == 64 ? ~UINT64_C(0) : (UINT64_C(1) << bits) - 1;
+
+            lcs += __builtin_popcountll(~v[w] & used);
+        }
+
+        if (v != v_stack)
+            free(v);
+    }
+
+    for (size_t i = 0; i < len_s1; i++)
+        thread_peq[pattern[i] * words + i / 64] = 0;
+
+    return (int)(len_s1 + len_s2 - 2 * lcs);
+}
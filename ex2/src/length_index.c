@@ -0,0 +1,131 @@
+#include "../include/utils.h"
+
+/**
+ * @brief Groups the words of a dictionary by length.
+ * 
+ * The words are counting-sorted by length, so each bucket keeps them in dictionary order;
+ * the index only stores pointers to the words and their positions.
+ * 
+ * @param dictionary An array of dictionary words.
+ * @param signatures The signatures of the words, by position, or NULL to compute every
+ *                   bounded distance; they must outlive the index.
+ * @param lines The number of words in the dictionary.
+ * @return The index, to be released with length_index_free().
+ */
+LengthIndex *length_index_build(char **dictionary, const WordSignature *signatures, size_t lines) {
+    if (!dictionary && lines > 0)
+        GENERIC_ERROR("length_index_build: dictionary not provided");
+
+    LengthIndex *index = calloc(1, sizeof(LengthIndex));
+    if (!index)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    for (size_t i = 0; i < lines; i++) {
+        size_t len = strlen(dictionary[i]);
+        if (len > index->max_len)
+            index->max_len = len;
+    }
+
+    index->count = lines;
+    index->signatures = signatures;
+    index->start = calloc(index->max_len + 2, sizeof(size_t));
+    index->words = malloc((lines ? lines : 1) * sizeof(char *));
+    index->ids = malloc((lines ? lines : 1) * sizeof(uint32_t));
+    if (!index->start || !index->words || !index->ids)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t i = 0; i < lines; i++)
+        index->start[strlen(dictionary[i]) + 1]++;
+    for (size_t len = 1; len <= index->max_len + 1; len++)
+        index->start[len] += index->start[len - 1];
+
+    // start[len] is used as the insertion point of bucket len, then shifted back
+    for (size_t i = 0; i < lines; i++) {
+        size_t slot = index->start[strlen(dictionary[i])]++;
+
+        index->words[slot] = dictionary[i];
+        index->ids[slot] = (uint32_t)i;
+    }
+    for (size_t len = index->max_len + 1; len > 0; len--)
+        index->start[len] = index->start[len - 1];
+    index->start[0] = 0;
+
+    return index;
+}
+
+void length_index_free(LengthIndex *index) {
+    if (!index)
+        return ;
+
+    free(index->start);
+    free(index->words);
+    free(index->ids);
+    free(index);
+}
+
+/**
+ * @brief Scans the bucket of words of length len, bounding each distance by the best one
+ * so far; with signatures, the words they rule out are skipped before any distance.
+ */
+static void scan_bucket(const LengthIndex *index, size_t len, const char *word, const WordSignature *signature, Corrections *corrections) {
+    for (size_t i = index->start[len]; i < index->start[len + 1]; i++) {
+        int bound = corrections->distance;
+
+        if (signature && !signature_filter(signature, &index->signatures[index->ids[i]], bound, corrections->rejected))
+            continue;
+
+        int distance = edit_distance_bounded(word, index->words[i], bound);
+
+        corrections->examined++;
+        if (distance <= bound)
+            corrections_offer(corrections, index->ids[i], distance);
+    }
+}
+
+/**
+ * @brief Finds the dictionary words at minimum edit distance from a word.
+ * 
+ * With insertions and deletions only, the distance between two words is at least the
+ * difference of their lengths. The bucket of the word's length is scanned first, then
+ * the buckets one character shorter and longer, and so on outwards; the search stops
+ * as soon as the length gap exceeds the best distance found, since no bucket from
+ * there on can hold a closer or equally close word. When the index has signatures,
+ * each word first goes through signature_filter() and corrections->rejected counts
+ * the words ruled out by each of its stages.
+ * 
+ * @param index The length index of the dictionary.
+ * @param word The word to correct.
+ * @param corrections Receives the minimum distance and the positions of the words at
+ *                    that distance, in dictionary order.
+ */
+void length_index_search(const LengthIndex *index, const char *word, Corrections *corrections) {
+    if (!index || !word || !corrections)
+        GENERIC_ERROR("length_index_search: arguments not provided");
+
+    corrections_clear(corrections);
+
+    WordSignature query;
+    const WordSignature *signature = NULL;
+    if (index->signatures) {
+        signature_compute(word, &query);
+        signature = &query;
+    }
+
+    size_t len = strlen(word);
+    for (size_t gap = 0; ; gap++) {
+        if (corrections->count > 0 && gap > (size_t)corrections->distance)
+            break;
+
+        int below = gap <= len;
+        int above = len + gap <= index->max_len;
+        if (!below && !above)
+            break;
+
+        if (below && len - gap <= index->max_len)
+            scan_bucket(index, len - gap, word, signature, corrections);
+        if (gap > 0 && above)
+            scan_bucket(index, len + gap, word, signature, corrections);
+    }
+
+    corrections_finish(corrections);
+}
@@ -1,4 +1,5 @@
 #include "../include/utils.h"
+#include <getopt.h>
 
 /**
  * @brief Counts the number of lines in a given file.
@@ -59,17 +60,26 @@ static size_t count_words(FILE *infile) {
  * @brief Saves the words from a dictionary file into an array.
  * 
  * This function reads lines from a dictionary file and stores each line as a word
- * in a dynamically allocated array of strings.
+ * in a dynamically allocated array of strings, computing the signature of each word
+ * on the way (see signature_filter) when asked to.
  * 
  * @param dictionary The file to read dictionary words from.
  * @param lines The number of lines (words) in the dictionary file.
+ * @param signatures Receives a dynamically allocated array of the word signatures, or
+ *                   NULL to skip them.
  * @return A dynamically allocated array of strings containing the dictionary words.
  */
-static char **save_dictionary(FILE *dictionary, size_t lines) {
+static char **save_dictionary(FILE *dictionary, size_t lines, WordSignature **signatures) {
     char **dictionary_words = malloc(lines * sizeof(char *));
     if (!dictionary_words)
         GENERIC_ERROR("malloc: memory allocation failed");
 
+    if (signatures) {
+        *signatures = malloc((lines ? lines : 1) * sizeof(WordSignature));
+        if (!*signatures)
+            GENERIC_ERROR("malloc: memory allocation failed");
+    }
+
     char buffer[BUFSIZ];
     for (size_t i = 0; i < lines; i++) {
         if(!fgets(buffer, sizeof(buffer), dictionary))
@@ -80,6 +90,9 @@ static char **save_dictionary(FILE *dictionary, size_t lines) {
         dictionary_words[i] = strdup(buffer);
         if (!dictionary_words[i])
             GENERIC_ERROR("strdup: memory allocation failed");
+
+        if (signatures)
+            signature_compute(dictionary_words[i], &(*signatures)[i]);
     }
     
     return dictionary_words;
@@ -123,68 +136,225 @@ static char **save_correctme(FILE *correctme, size_t words) {
     return correctme_words;
 }
 
+// search engines selectable with --engine
+typedef enum {
+    ENGINE_LENGTH,
+    ENGINE_BKTREE,
+    ENGINE_TRIE,
+    ENGINE_DELETIONS,
+    ENGINE_QGRAM,
+    ENGINE_AUTOMATON
+} Engine;
+
+static const char *engine_names[] = { "length", "bktree", "trie", "deletions", "qgram", "automaton" };
+
+// the engines that run signature_filter before each exact distance
+static int engine_filters(Engine engine) {
+    return engine == ENGINE_LENGTH || engine == ENGINE_DELETIONS || engine == ENGINE_QGRAM;
+}
+
+// settings of print_corrections, from the command line
+typedef struct {
+    Engine engine;
+    int deletions;      // largest number of deletions per word of the deletion index
+    int q;              // length of the grams of the q-gram index
+    int max_distance;   // largest distance the automaton accepts
+    int stats;          // print the search counters on stderr
+} SearchOptions;
+
+/**
+ * @brief Prints the counters of a run as one JSON object: the words whose distance was
+ * computed and, for the engines that filter, the ones each stage of the signature filter
+ * rejected before that.
+ */
+static void print_stats(FILE *out, Engine engine, size_t words, size_t examined, const size_t *rejected) {
+    fprintf(out, "{\"engine\":\"%s\",\"queries\":%zu,\"distances\":%zu", engine_names[engine], words, examined);
+    if (engine_filters(engine))
+        fprintf(out, ",\"rejected\":{\"length\":%zu,\"mask\":%zu,\"counts\":%zu}",
+                rejected[SIGNATURE_LENGTH], rejected[SIGNATURE_MASK], rejected[SIGNATURE_COUNTS]);
+    fprintf(out, "}\n");
+}
+
 /**
  * @brief Prints corrections for words based on the dictionary.
  * 
  * This function compares each word to be corrected with the words in the dictionary using
  * the edit distance algorithm, and prints possible corrections with the minimum edit distance.
+ * The dictionary is indexed once by the chosen engine: by word length, searched outwards
+ * from the length of each word (see length_index_search), in a BK-tree, searched with a
+ * radius that shrinks to the best distance found (see bk_tree_search), or in a trie,
+ * sharing the rows of the edit distance table across common prefixes (see trie_search),
+ * by deletion variants, looked up from the variants of each word and verified (see
+ * deletion_index_search), or by q-grams, verifying only the words sharing enough grams
+ * with each word (see qgram_index_search). All of them report the same corrections,
+ * in dictionary order. The automaton engine walks the trie with an automaton accepting
+ * the words within the maximum distance of each word (see automaton_search): it reports
+ * the same corrections when they are that close, and none otherwise.
  * 
  * @param dictionary An array of dictionary words.
  * @param correctme An array of words to be corrected.
  * @param lines The number of lines (words) in the dictionary.
+ * @param signatures The signatures of the dictionary words, used by the length, deletion
+ *                   and q-gram indexes; NULL for the other engines.
  * @param words The number of words to be corrected.
+ * @param options The engine and its settings.
  */
-static void print_corrections(char **dictionary, char **correctme, size_t lines, size_t words) {
-    for(size_t i = 0; i < words; i++) {
-        int min = INT_MAX;
+static void print_corrections(char **dictionary, char **correctme, size_t lines, const WordSignature *signatures, size_t words, const SearchOptions *options) {
+    LengthIndex *length_index = NULL;
+    BkTree *bk_tree = NULL;
+    Trie *trie = NULL;
+    DeletionIndex *deletion_index = NULL;
+    QgramIndex *qgram_index = NULL;
+    Corrections corrections = {0};
+    size_t examined = 0;
+    size_t rejected[SIGNATURE_STAGES] = {0};
+    Engine engine = options->engine;
 
-        printf("[%ld] word to correct: %s\n", i + 1, correctme[i]);
+    switch (engine) {
+        case ENGINE_LENGTH:
+            length_index = length_index_build(dictionary, signatures, lines);
+            break;
+        case ENGINE_BKTREE:
+            bk_tree = bk_tree_build(dictionary, lines);
+            break;
+        case ENGINE_TRIE:
+        case ENGINE_AUTOMATON:
+            trie = trie_build(dictionary, lines);
+            break;
+        case ENGINE_DELETIONS:
+            deletion_index = deletion_index_build(dictionary, signatures, lines, options->deletions);
+            break;
+        case ENGINE_QGRAM:
+            qgram_index = qgram_index_build(dictionary, signatures, lines, options->q);
+            break;
+    }
 
-        int *array = malloc(lines * sizeof(int));
-        for(size_t j = 0; j < lines; j++) {
-            array[j] = edit_distance_dyn(correctme[i], dictionary[j]);
+    for(size_t i = 0; i < words; i++) {
+        printf("[%ld] word to correct: %s\n", i + 1, correctme[i]);
 
-            if(array[j] < min)
-                min = array[j];
+        switch (engine) {
+            case ENGINE_LENGTH:
+                length_index_search(length_index, correctme[i], &corrections);
+                break;
+            case ENGINE_BKTREE:
+                bk_tree_search(bk_tree, correctme[i], &corrections);
+                break;
+            case ENGINE_TRIE:
+                trie_search(trie, correctme[i], &corrections);
+                break;
+            case ENGINE_DELETIONS:
+                deletion_index_search(deletion_index, correctme[i], &corrections);
+                break;
+            case ENGINE_QGRAM:
+                qgram_index_search(qgram_index, correctme[i], &corrections);
+                break;
+            case ENGINE_AUTOMATON:
+                automaton_search(trie, correctme[i], options->max_distance, &corrections);
+                break;
         }
 
-        // if(min == 0)
-            // continue;
+        examined += corrections.examined;
+        for (size_t s = 0; s < SIGNATURE_STAGES; s++)
+            rejected[s] += corrections.rejected[s];
 
-        if(min != 0) {
-            printf("minimum edit distance: %d | possible fixes:", min);
+        // only the automaton bounds the distance; the other engines always find the closest words
+        if (engine == ENGINE_AUTOMATON && corrections.count == 0) {
+            printf("no possible fixes within edit distance %d", options->max_distance);
+        } else if(corrections.distance != 0) {
+            printf("minimum edit distance: %d | possible fixes:", corrections.distance);
 
-            for(size_t j = 0; j < lines; j++) {
-                if(array[j] == min)
-                    printf(" %s", dictionary[j]);
-            }
+            for(size_t j = 0; j < corrections.count; j++)
+                printf(" %s", dictionary[corrections.ids[j]]);
         } else
             printf("found in dictionary");
         printf("\n\n");
-
-        free(array);
     }
+
+    if (options->stats)
+        print_stats(stderr, engine, words, examined, rejected);
+
+    corrections_free(&corrections);
+    length_index_free(length_index);
+    bk_tree_free(bk_tree);
+    trie_free(trie);
+    deletion_index_free(deletion_index);
+    qgram_index_free(qgram_index);
 }
 
-int main(int argc, char const *argv[]) {
-    if(argc != 3)
-        GENERIC_ERROR("Usage: bin/main_ex2 <dictionary_txt> <correctme_txt>");
+int main(int argc, char *argv[]) {
+    static const struct option options[] = {
+        { "engine", required_argument, NULL, 'e' },
+        { "deletions", required_argument, NULL, 'd' },
+        { "qgram", required_argument, NULL, 'q' },
+        { "stats", no_argument, NULL, 's' },
+        { "max-distance", required_argument, NULL, 'k' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *usage = "Usage: bin/main_ex2 [--engine trie|bktree|length|deletions|qgram|automaton] [--deletions N] [--qgram 2|3] [--max-distance N] [--stats] <dictionary_txt> <correctme_txt>";
+    SearchOptions search = { ENGINE_TRIE, 2, 3, 2, 0 };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "e:d:q:sk:", options, NULL)) != -1) {
+        switch (opt) {
+            case 'e':
+                if (strcmp(optarg, "trie") == 0)
+                    search.engine = ENGINE_TRIE;
+                else if (strcmp(optarg, "bktree") == 0)
+                    search.engine = ENGINE_BKTREE;
+                else if (strcmp(optarg, "length") == 0)
+                    search.engine = ENGINE_LENGTH;
+                else if (strcmp(optarg, "deletions") == 0)
+                    search.engine = ENGINE_DELETIONS;
+                else if (strcmp(optarg, "qgram") == 0)
+                    search.engine = ENGINE_QGRAM;
+                else if (strcmp(optarg, "automaton") == 0)
+                    search.engine = ENGINE_AUTOMATON;
+                else
+                    GENERIC_ERROR("Error: --engine expects trie, bktree, length, deletions, qgram or automaton");
+                break;
+            case 'd':
+                search.deletions = atoi(optarg);
+                if (search.deletions < 0 || search.deletions > DELETION_MAX_DEPTH)
+                    GENERIC_ERROR("Error: --deletions expects a number from 0 to 4");
+                break;
+            case 'q':
+                search.q = atoi(optarg);
+                if (search.q < 2 || search.q > 3)
+                    GENERIC_ERROR("Error: --qgram expects 2 or 3");
+                break;
+            case 's':
+                search.stats = 1;
+                break;
+            case 'k':
+                search.max_distance = atoi(optarg);
+                if (search.max_distance < 0 || search.max_distance > AUTOMATON_MAX_DISTANCE)
+                    GENERIC_ERROR("Error: --max-distance expects a number from 0 to 3");
+                break;
+            default:
+                GENERIC_ERROR(usage);
+        }
+    }
+
+    if(argc - optind != 2)
+        GENERIC_ERROR(usage);
+    argv += optind;
 
-    FILE *dictionary = fopen(argv[1], "r");
+    FILE *dictionary = fopen(argv[0], "r");
     if(!dictionary)
         GENERIC_ERROR("fopen: error opening dictionary file");
-    FILE *correctme = fopen(argv[2], "r");
+    FILE *correctme = fopen(argv[1], "r");
     if(!correctme)
         GENERIC_ERROR("fopen: error opening correctme file");
 
     size_t lines = count_lines(dictionary);
-    char **dictionary_words = save_dictionary(dictionary, lines);
+    WordSignature *signatures = NULL;
+    char **dictionary_words = save_dictionary(dictionary, lines, engine_filters(search.engine) ? &signatures : NULL);
 
     size_t words = count_words(correctme);
     char **correctme_words = save_correctme(correctme, words);
 
-    print_corrections(dictionary_words, correctme_words, lines, words);
+    print_corrections(dictionary_words, correctme_words, lines, signatures, words, &search);
 
     fclose(dictionary);
     fclose(correctme);
-}
\ No newline at end of file
+}
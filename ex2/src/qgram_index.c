@@ -0,0 +1,424 @@
+#include "../include/utils.h"
+
+#define QGRAM_EMPTY UINT32_MAX
+// symbol of the padding before and after a word, outside the range of characters
+#define QGRAM_PAD 256
+
+// shared q-gram counts of the dictionary words, one per word, zero between searches
+static __thread uint32_t *thread_counts;
+static __thread size_t thread_counts_size;
+
+/**
+ * @brief Calls visit with the key of every q-gram of the word padded with q - 1 symbols on
+ * each side, len + q - 1 of them. A key packs the q symbols in 9 bits each.
+ */
+static void visit_qgrams(const char *word, size_t len, int q, void (*visit)(uint32_t key, void *arg), void *arg) {
+    const unsigned char *s = (const unsigned char *)word;
+
+    for (size_t i = 0; i < len + q - 1; i++) {
+        uint32_t key = 0;
+
+        // the gram starting at i covers positions i - (q - 1) to i of the word
+        for (size_t j = 0; j < (size_t)q; j++) {
+            size_t pos = i + j;
+            uint32_t symbol = pos < (size_t)q - 1 || pos >= len + q - 1 ? QGRAM_PAD : s[pos - (q - 1)];
+
+            key = key << 9 | symbol;
+        }
+        visit(key, arg);
+    }
+}
+
+static size_t find_slot(const QgramIndex *index, uint32_t key) {
+    size_t slot = (key * UINT32_C(2654435761)) & index->mask;
+
+    while (index->keys[slot] != QGRAM_EMPTY && index->keys[slot] != key)
+        slot = (slot + 1) & index->mask;
+
+    return slot;
+}
+
+// allocates an empty table of slots entries, for the grams and their occurrence counts
+static void reset_table(QgramIndex *index, size_t slots) {
+    index->mask = slots - 1;
+    index->keys = malloc(slots * sizeof(uint32_t));
+    index->end = calloc(slots, sizeof(size_t));
+    if (!index->keys || !index->end)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    memset(index->keys, 0xff, slots * sizeof(uint32_t));
+}
+
+/**
+ * @brief Counts the occurrences of a gram, in the end field of its slot; the table
+ * doubles whenever it gets half full.
+ */
+static void count_qgram(uint32_t key, void *arg) {
+    QgramIndex *index = arg;
+    size_t slot = find_slot(index, key);
+
+    if (index->keys[slot] == QGRAM_EMPTY) {
+        if (2 * (index->distinct + 1) > index->mask + 1) {
+            uint32_t *keys = index->keys;
+            size_t *counts = index->end;
+            size_t slots = index->mask + 1;
+
+            reset_table(index, 2 * slots);
+            for (size_t i = 0; i < slots; i++) {
+                if (keys[i] != QGRAM_EMPTY) {
+                    size_t moved = find_slot(index, keys[i]);
+
+                    index->keys[moved] = keys[i];
+                    index->end[moved] = counts[i];
+                }
+            }
+            free(keys);
+            free(counts);
+
+            slot = find_slot(index, key);
+        }
+
+        index->keys[slot] = key;
+        index->distinct++;
+    }
+    index->end[slot]++;
+}
+
+// word being added to the posting lists, and the ids of each list in dictionary order
+typedef struct {
+    QgramIndex *index;
+    uint32_t *ids;
+    uint32_t id;
+} Posting;
+
+static void post_qgram(uint32_t key, void *arg) {
+    Posting *posting = arg;
+    size_t slot = find_slot(posting->index, key);
+
+    posting->ids[posting->index->end[slot]++] = posting->id;
+}
+
+// appends value in LEB128, 7 bits per byte
+static size_t put_varint(uint8_t *out, uint32_t value) {
+    size_t n = 0;
+
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+
+    return n;
+}
+
+static uint32_t get_varint(const uint8_t **in) {
+    uint32_t value = 0;
+    int shift = 0;
+
+    while (**in & 0x80) {
+        value |= (uint32_t)(*(*in)++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= (uint32_t)*(*in)++ << shift;
+
+    return value;
+}
+
+/**
+ * @brief Builds the q-gram inverted index of a dictionary.
+ * 
+ * Each word is padded with q - 1 symbols on both sides, so a word of n characters has
+ * n + q - 1 grams. An open addressing table maps every gram to its posting list: the
+ * positions of the words holding it, once per occurrence, ascending, stored as LEB128
+ * deltas from the previous position in one byte array; the table grows with the number
+ * of distinct grams. The words are also grouped by length for the ones no posting list
+ * can reach.
+ * 
+ * @param dictionary An array of dictionary words.
+ * @param signatures The signatures of the words, by position, or NULL to compute every
+ *                   bounded distance; they must outlive the index.
+ * @param lines The number of words in the dictionary.
+ * @param q The length of the grams, 2 (bigrams) or 3 (trigrams).
+ * @return The index, to be released with qgram_index_free().
+ */
+QgramIndex *qgram_index_build(char **dictionary, const WordSignature *signatures, size_t lines, int q) {
+    if (!dictionary && lines > 0)
+        GENERIC_ERROR("qgram_index_build: dictionary not provided");
+    if (q < 2 || q > 3)
+        GENERIC_ERROR("qgram_index_build: q must be 2 or 3");
+    if (lines >= QGRAM_EMPTY)
+        GENERIC_ERROR("qgram_index_build: too many words");
+
+    QgramIndex *index = calloc(1, sizeof(QgramIndex));
+    if (!index)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    index->words = dictionary;
+    index->signatures = signatures;
+    index->count = lines;
+    index->q = q;
+
+    size_t grams = 0;
+    reset_table(index, 1024);
+    for (size_t i = 0; i < lines; i++) {
+        size_t len = strlen(dictionary[i]);
+
+        grams += len + q - 1;
+        visit_qgrams(dictionary[i], len, q, count_qgram, index);
+    }
+
+    size_t slots = index->mask + 1;
+    index->begin = malloc(slots * sizeof(size_t));
+    uint32_t *ids = malloc((grams ? grams : 1) * sizeof(uint32_t));
+    if (!index->begin || !ids)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    // end becomes the insertion point of each list, and its end once the lists are filled
+    size_t offset = 0;
+    for (size_t slot = 0; slot < slots; slot++) {
+        size_t count = index->end[slot];
+
+        index->begin[slot] = index->end[slot] = offset;
+        offset += count;
+    }
+
+    for (size_t i = 0; i < lines; i++) {
+        Posting posting = { index, ids, (uint32_t)i };
+
+        visit_qgrams(dictionary[i], strlen(dictionary[i]), q, post_qgram, &posting);
+    }
+
+    // a delta takes at most 5 bytes, and only the first of a list can be large
+    index->postings = malloc(5 * (grams ? grams : 1));
+    if (!index->postings)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    size_t size = 0;
+    for (size_t slot = 0; slot < slots; slot++) {
+        size_t first = index->begin[slot], last = index->end[slot];
+        uint32_t prev = 0;
+
+        index->begin[slot] = size;
+        for (size_t i = first; i < last; i++) {
+            size += put_varint(index->postings + size, ids[i] - prev);
+            prev = ids[i];
+        }
+        index->end[slot] = size;
+    }
+
+    free(ids);
+
+    uint8_t *postings = realloc(index->postings, size ? size : 1);
+    if (postings)
+        index->postings = postings;
+
+    index->lengths = length_index_build(dictionary, NULL, lines);
+
+    return index;
+}
+
+void qgram_index_free(QgramIndex *index) {
+    if (!index)
+        return ;
+
+    free(index->keys);
+    free(index->begin);
+    free(index->end);
+    free(index->postings);
+    length_index_free(index->lengths);
+    free(index);
+}
+
+// grams of the word being searched
+typedef struct {
+    uint32_t *keys;
+    size_t count;
+} QueryGrams;
+
+static void collect_qgram(uint32_t key, void *arg) {
+    QueryGrams *grams = arg;
+
+    grams->keys[grams->count++] = key;
+}
+
+static int compare_key(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Tells whether a word of length len sharing count grams with the query can be
+ * within distance bound of it.
+ * 
+ * Both words are built from their longest common subsequence s by inserting d = bound or
+ * fewer characters in total. An insertion between two characters of s breaks only the q - 1
+ * padded grams spanning that gap, so of the |s| + q - 1 grams of s at most (q - 1) * d are
+ * broken on the way to either word, and the words share at least |s| + q - 1 - (q - 1) * d
+ * grams, with |s| = (|query| + len - d) / 2.
+ */
+static int passes_count_filter(size_t query_len, size_t len, uint32_t count, int q, int bound) {
+    if ((size_t)bound >= query_len + len)
+        return 1;
+
+    int64_t twice_least = (int64_t)(query_len + len) - bound + 2 * (int64_t)(q - 1) * (1 - bound);
+
+    return 2 * (int64_t)count >= twice_least;
+}
+
+/**
+ * @brief Offers word id to corrections if it is within the best distance so far; with a
+ * signature, the words it rules out are skipped before any distance.
+ */
+static void verify_candidate(const QgramIndex *index, const char *word, const WordSignature *signature, uint32_t id, Corrections *corrections) {
+    int bound = corrections->distance;
+
+    if (signature && !signature_filter(signature, &index->signatures[id], bound, corrections->rejected))
+        return;
+
+    int distance = edit_distance_bounded(word, index->words[id], bound);
+
+    corrections->examined++;
+    if (distance <= bound)
+        corrections_offer(corrections, id, distance);
+}
+
+/**
+ * @brief Finds the dictionary words at minimum edit distance from a word.
+ * 
+ * The posting lists of the grams of the word are merged with ScanCount: one counter per
+ * dictionary word, raised once per gram occurrence it shares with the word. The words
+ * reached are then verified from the most shared grams down, so that the best distance
+ * drops early; a word is verified only if its count meets the lower bound implied by the
+ * best distance so far and its length is within that distance. Words sharing no gram
+ * can only be close when that bound is zero or less, which happens for short words or
+ * large distances: the buckets of such lengths are scanned for them. When the index has
+ * signatures, each word verified first goes through signature_filter() and
+ * corrections->rejected counts the words ruled out by each of its stages.
+ * 
+ * @param index The q-gram index of the dictionary.
+ * @param word The word to correct.
+ * @param corrections Receives the minimum distance and the positions of the words at
+ *                    that distance, in dictionary order; examined counts the words verified.
+ */
+void qgram_index_search(const QgramIndex *index, const char *word, Corrections *corrections) {
+    if (!index || !word || !corrections)
+        GENERIC_ERROR("qgram_index_search: arguments not provided");
+
+    corrections_clear(corrections);
+
+    WordSignature query;
+    const WordSignature *signature = NULL;
+    if (index->signatures) {
+        signature_compute(word, &query);
+        signature = &query;
+    }
+
+    if (thread_counts_size < index->count) {
+        free(thread_counts);
+        thread_counts = calloc(index->count ? index->count : 1, sizeof(uint32_t));
+        if (!thread_counts)
+            GENERIC_ERROR("calloc: memory allocation failed");
+        thread_counts_size = index->count;
+    }
+
+    size_t len = strlen(word);
+    QueryGrams grams = { malloc((len + index->q) * sizeof(uint32_t)), 0 };
+    if (!grams.keys)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    visit_qgrams(word, len, index->q, collect_qgram, &grams);
+    qsort(grams.keys, grams.count, sizeof(uint32_t), compare_key);
+
+    uint32_t *candidates = NULL;
+    size_t count = 0, cap = 0;
+
+    for (size_t g = 0; g < grams.count; ) {
+        // a gram occurring m times in the word is shared at most m times with each word
+        size_t m = 1;
+        while (g + m < grams.count && grams.keys[g + m] == grams.keys[g])
+            m++;
+
+        size_t slot = find_slot(index, grams.keys[g]);
+        const uint8_t *in = index->postings + index->begin[slot];
+        const uint8_t *end = index->postings + index->end[slot];
+        uint32_t id = 0, last = QGRAM_EMPTY;
+        size_t run = 0;
+
+        while (index->keys[slot] != QGRAM_EMPTY && in < end) {
+            id += get_varint(&in);
+            run = id == last ? run + 1 : 1;
+            last = id;
+
+            if (run > m)
+                continue;
+            if (thread_counts[id]++ == 0) {
+                if (count == cap) {
+                    cap = cap ? cap * 2 : 256;
+                    candidates = realloc(candidates, cap * sizeof(uint32_t));
+                    if (!candidates)
+                        GENERIC_ERROR("realloc: memory allocation failed");
+                }
+                candidates[count++] = id;
+            }
+        }
+
+        g += m;
+    }
+
+    // counting sort by shared grams, which are at most len + q - 1, most shared first
+    size_t most = len + index->q - 1;
+    size_t *first = calloc(most + 2, sizeof(size_t));
+    uint32_t *order = malloc((count ? count : 1) * sizeof(uint32_t));
+    if (!first || !order)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t i = 0; i < count; i++)
+        first[most - thread_counts[candidates[i]] + 1]++;
+    for (size_t c = 1; c <= most + 1; c++)
+        first[c] += first[c - 1];
+    for (size_t i = 0; i < count; i++)
+        order[first[most - thread_counts[candidates[i]]]++] = candidates[i];
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t shared = thread_counts[order[i]];
+
+        // the bound grows with the length, so if the shortest length in reach fails,
+        // this candidate and all the later ones, sharing fewer grams, fail too
+        size_t shortest = len > (size_t)corrections->distance ? len - corrections->distance : 0;
+        if (!passes_count_filter(len, shortest, shared, index->q, corrections->distance))
+            break;
+
+        size_t word_len = strlen(index->words[order[i]]);
+        size_t gap = word_len > len ? word_len - len : len - word_len;
+
+        if (gap <= (size_t)corrections->distance && passes_count_filter(len, word_len, shared, index->q, corrections->distance))
+            verify_candidate(index, word, signature, order[i], corrections);
+    }
+
+    free(first);
+    free(order);
+
+    // the words sharing no gram, in the lengths where a count of zero passes the filter
+    const LengthIndex *lengths = index->lengths;
+    for (size_t word_len = 0; word_len <= lengths->max_len; word_len++) {
+        size_t gap = word_len > len ? word_len - len : len - word_len;
+
+        if (gap > (size_t)corrections->distance || !passes_count_filter(len, word_len, 0, index->q, corrections->distance))
+            continue;
+
+        for (size_t i = lengths->start[word_len]; i < lengths->start[word_len + 1]; i++) {
+            if (thread_counts[lengths->ids[i]] == 0)
+                verify_candidate(index, word, signature, lengths->ids[i], corrections);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+        thread_counts[candidates[i]] = 0;
+
+    free(candidates);
+    free(grams.keys);
+
+    corrections_finish(corrections);
+}
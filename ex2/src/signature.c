@@ -0,0 +1,82 @@
+#include "../include/utils.h"
+
+// letters per word of the count vector, 4 bits each
+#define LETTERS_PER_WORD 13
+
+/**
+ * @brief Computes the signature of a word: its length, which of the letters a to z it
+ * holds, and how many times each, saturated at 15.
+ * 
+ * Other characters only count in the length; leaving them out of the mask and of the
+ * counts, like saturating the counts, can only lower the bounds derived from them.
+ */
+void signature_compute(const char *word, WordSignature *signature) {
+    if (!word || !signature)
+        GENERIC_ERROR("signature_compute: arguments not provided");
+
+    *signature = (WordSignature){0};
+
+    const unsigned char *c = (const unsigned char *)word;
+    for (; *c; c++) {
+        if (*c < 'a' || *c > 'z')
+            continue;
+
+        unsigned letter = *c - 'a';
+        uint64_t *counts = &signature->counts[letter / LETTERS_PER_WORD];
+        unsigned shift = 4 * (letter % LETTERS_PER_WORD);
+
+        signature->mask |= UINT32_C(1) << letter;
+        if (((*counts >> shift) & 0xf) != 0xf)
+            *counts += UINT64_C(1) << shift;
+    }
+    signature->length = (uint32_t)(c - (const unsigned char *)word);
+}
+
+/**
+ * @brief Tells whether two words may be within distance bound of each other, looking only
+ * at their signatures.
+ * 
+ * Each insertion or deletion changes the length by one and the count of one letter by
+ * one, so the edit distance is at least the length difference and at least the sum of
+ * the differences of the letter counts (the bag distance); each letter held by only one
+ * of the words adds at least one to that sum, so the number of bits in which the masks
+ * differ is a lower bound too. The bounds are tried from the cheapest: the length, the
+ * mask, then the 26 counts.
+ * 
+ * @param a The signature of the first word.
+ * @param b The signature of the second word.
+ * @param bound The largest distance of interest.
+ * @param rejected Counters of the pairs rejected by each stage, SIGNATURE_STAGES of them.
+ * @return 1 if the distance may be within bound, 0 if the pair was rejected.
+ */
+int signature_filter(const WordSignature *a, const WordSignature *b, int bound, size_t *rejected) {
+    if (bound < 0)
+        GENERIC_ERROR("signature_filter: negative bound");
+
+    uint32_t gap = a->length > b->length ? a->length - b->length : b->length - a->length;
+    if (gap > (uint32_t)bound) {
+        rejected[SIGNATURE_LENGTH]++;
+        return 0;
+    }
+
+    if (__builtin_popcount(a->mask ^ b->mask) > bound) {
+        rejected[SIGNATURE_MASK]++;
+        return 0;
+    }
+
+    int sum = 0;
+    for (size_t w = 0; w < 2; w++) {
+        uint64_t x = a->counts[w], y = b->counts[w];
+
+        for (unsigned shift = 0; shift < 4 * LETTERS_PER_WORD; shift += 4) {
+            int diff = (int)((x >> shift) & 0xf) - (int)((y >> shift) & 0xf);
+            sum += diff < 0 ? -diff : diff;
+        }
+    }
+    if (sum > bound) {
+        rejected[SIGNATURE_COUNTS]++;
+        return 0;
+    }
+
+    return 1;
+}
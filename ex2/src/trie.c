@@ -0,0 +1,207 @@
+#include "../include/utils.h"
+
+#define TRIE_NONE UINT32_MAX
+
+// node waiting on the search stack, with the minimum of its parent's row
+typedef struct {
+    uint32_t node;
+    uint32_t depth;
+    int parent_min;
+} TriePending;
+
+// appends a node to the arena and returns its index
+static uint32_t trie_new_node(Trie *trie, unsigned char label) {
+    if (trie->count == trie->cap) {
+        size_t cap = trie->cap ? trie->cap * 2 : 1024;
+        TrieNode *nodes = realloc(trie->nodes, cap * sizeof(TrieNode));
+        if (!nodes)
+            GENERIC_ERROR("realloc: memory allocation failed");
+
+        trie->nodes = nodes;
+        trie->cap = cap;
+    }
+
+    trie->nodes[trie->count] = (TrieNode){ TRIE_NONE, TRIE_NONE, TRIE_NONE, label };
+    return (uint32_t)trie->count++;
+}
+
+/**
+ * @brief Builds a trie over the words of a dictionary.
+ * 
+ * All nodes live in one arena grown by doubling and refer to each other by index: each
+ * node links its first child and its next sibling, and a node where words end holds the
+ * position of the first of them, the others being chained through next_word (the
+ * dictionary may repeat a word).
+ * 
+ * @param dictionary An array of dictionary words.
+ * @param lines The number of words in the dictionary.
+ * @return The trie, to be released with trie_free().
+ */
+Trie *trie_build(char **dictionary, size_t lines) {
+    if (!dictionary && lines > 0)
+        GENERIC_ERROR("trie_build: dictionary not provided");
+    if (lines >= TRIE_NONE)
+        GENERIC_ERROR("trie_build: too many words");
+
+    Trie *trie = calloc(1, sizeof(Trie));
+    if (!trie)
+        GENERIC_ERROR("calloc: memory allocation failed");
+
+    trie->next_word = malloc((lines ? lines : 1) * sizeof(uint32_t));
+    if (!trie->next_word)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    trie_new_node(trie, '\0');
+
+    for (size_t i = 0; i < lines; i++) {
+        const unsigned char *c = (const unsigned char *)dictionary[i];
+        uint32_t node = 0;
+        size_t depth = 0;
+
+        for (; *c; c++, depth++) {
+            uint32_t child = trie->nodes[node].first_child;
+
+            while (child != TRIE_NONE && trie->nodes[child].label != *c)
+                child = trie->nodes[child].next_sibling;
+
+            if (child == TRIE_NONE) {
+                child = trie_new_node(trie, *c);
+                trie->nodes[child].next_sibling = trie->nodes[node].first_child;
+                trie->nodes[node].first_child = child;
+            }
+            node = child;
+        }
+
+        if (depth > trie->max_depth)
+            trie->max_depth = depth;
+
+        // repeated words are appended, so each chain stays in dictionary order
+        trie->next_word[i] = TRIE_NONE;
+        if (trie->nodes[node].word == TRIE_NONE) {
+            trie->nodes[node].word = (uint32_t)i;
+        } else {
+            uint32_t last = trie->nodes[node].word;
+            while (trie->next_word[last] != TRIE_NONE)
+                last = trie->next_word[last];
+            trie->next_word[last] = (uint32_t)i;
+        }
+    }
+
+    return trie;
+}
+
+void trie_free(Trie *trie) {
+    if (!trie)
+        return ;
+
+    free(trie->nodes);
+    free(trie->next_word);
+    free(trie);
+}
+
+// offers every dictionary word ending at node
+static void offer_words(const Trie *trie, uint32_t node, int distance, Corrections *corrections) {
+    for (uint32_t id = trie->nodes[node].word; id != TRIE_NONE; id = trie->next_word[id])
+        corrections_offer(corrections, id, distance);
+}
+
+/**
+ * @brief Pushes the children of a node; the one following the next character of the word,
+ * if any, ends on top so that the path of the word is searched first.
+ */
+static void push_children(const Trie *trie, uint32_t node, uint32_t depth, int row_min, unsigned char next, TriePending **stack, size_t *count, size_t *cap) {
+    size_t first = *count;
+
+    for (uint32_t child = trie->nodes[node].first_child; child != TRIE_NONE; child = trie->nodes[child].next_sibling) {
+        if (*count == *cap) {
+            *cap = *cap ? *cap * 2 : 256;
+            *stack = realloc(*stack, *cap * sizeof(TriePending));
+            if (!*stack)
+                GENERIC_ERROR("realloc: memory allocation failed");
+        }
+
+        (*stack)[(*count)++] = (TriePending){ child, depth + 1, row_min };
+    }
+
+    for (size_t i = first; next && i + 1 < *count; i++) {
+        if (trie->nodes[(*stack)[i].node].label == next) {
+            TriePending temp = (*stack)[i];
+            (*stack)[i] = (*stack)[*count - 1];
+            (*stack)[*count - 1] = temp;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Finds the dictionary words at minimum edit distance from a word.
+ * 
+ * The trie is walked depth first and every edge adds one row of the edit distance table
+ * between the word and the prefix spelled by the path, computed from the row of the
+ * parent: rows[d] belongs to the node at depth d on the current path, so the rows of a
+ * prefix shared by many words are computed once. A row never has a smaller minimum than
+ * the row above it, so a subtree is skipped as soon as the minimum of its parent's row
+ * exceeds the best distance found so far.
+ * 
+ * @param trie The trie of the dictionary.
+ * @param word The word to correct.
+ * @param corrections Receives the minimum distance and the positions of the words at
+ *                    that distance, in dictionary order; examined counts the rows computed.
+ */
+void trie_search(const Trie *trie, const char *word, Corrections *corrections) {
+    if (!trie || !word || !corrections)
+        GENERIC_ERROR("trie_search: arguments not provided");
+
+    corrections_clear(corrections);
+
+    size_t len = strlen(word);
+    size_t width = len + 1;
+    int *rows = malloc((trie->max_depth + 1) * width * sizeof(int));
+    if (!rows)
+        GENERIC_ERROR("malloc: memory allocation failed");
+
+    for (size_t j = 0; j <= len; j++)
+        rows[j] = j;
+    offer_words(trie, 0, (int)len, corrections);
+
+    TriePending *stack = NULL;
+    size_t count = 0, cap = 0;
+    push_children(trie, 0, 0, 0, (unsigned char)word[0], &stack, &count, &cap);
+
+    while (count > 0) {
+        TriePending pending = stack[--count];
+
+        if (pending.parent_min > corrections->distance)
+            continue;
+
+        const int *prev = rows + (pending.depth - 1) * width;
+        int *curr = rows + pending.depth * width;
+        char c = (char)trie->nodes[pending.node].label;
+        int row_min = curr[0] = pending.depth;
+
+        for (size_t j = 1; j <= len; j++) {
+            int d;
+
+            // no edit needed
+            if (word[j - 1] == c)
+                d = prev[j - 1];
+            else
+                d = 1 + (prev[j] < curr[j - 1] ? prev[j] : curr[j - 1]);
+
+            curr[j] = d;
+            if (d < row_min)
+                row_min = d;
+        }
+
+        corrections->examined++;
+        offer_words(trie, pending.node, curr[len], corrections);
+
+        if (row_min <= corrections->distance)
+            push_children(trie, pending.node, pending.depth, row_min, pending.depth < len ? (unsigned char)word[pending.depth] : '\0', &stack, &count, &cap);
+    }
+
+    free(stack);
+    free(rows);
+
+    corrections_finish(corrections);
+}
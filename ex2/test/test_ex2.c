@@ -1,5 +1,13 @@
 #include "../../lib/unity.h"
 #include "../src/edit_distance.c"
+#include "../src/corrections.c"
+#include "../src/signature.c"
+#include "../src/length_index.c"
+#include "../src/bk_tree.c"
+#include "../src/trie.c"
+#include "../src/deletion_index.c"
+#include "../src/qgram_index.c"
+#include "../src/automaton.c"
 
 // edit distance tests
 static void edit_distance_one_delete() {
@@ -115,6 +123,521 @@ static void edit_distance_dyn_s2() {
     TEST_ASSERT_TRUE(edit_distance_dyn(a, b) == 7);
 }
 
+// fills out with len letters out of the first letters of the alphabet, so words share many characters
+static void random_word(char *out, size_t len, size_t letters, unsigned *seed) {
+    for (size_t i = 0; i < len; i++)
+        out[i] = 'a' + rand_r(seed) % letters;
+    out[len] = '\0';
+}
+
+static void edit_distance_dyn_ws_matches_recursive() {
+    EditWorkspace ws = {0};
+    unsigned seed = 1;
+    char a[16], b[16];
+
+    for (size_t t = 0; t < 500; t++) {
+        random_word(a, rand_r(&seed) % 9, 3, &seed);
+        random_word(b, rand_r(&seed) % 9, 3, &seed);
+
+        TEST_ASSERT_EQUAL_INT(edit_distance(a, b), edit_distance_dyn_ws(a, b, &ws));
+    }
+
+    edit_workspace_free(&ws);
+}
+
+static void edit_distance_dyn_ws_grows_workspace() {
+    EditWorkspace ws = {0};
+    char a[1001], b[1001];
+
+    memset(a, 'a', 1000);
+    a[1000] = '\0';
+    memset(b, 'b', 1000);
+    b[1000] = '\0';
+
+    TEST_ASSERT_EQUAL_INT(2, edit_distance_dyn_ws("ab", "ba", &ws));
+    TEST_ASSERT_EQUAL_INT(2000, edit_distance_dyn_ws(a, b, &ws));
+    TEST_ASSERT_TRUE(ws.cap >= 2 * 1001);
+    TEST_ASSERT_EQUAL_INT(1, edit_distance_dyn_ws("casa", "cassa", &ws));
+
+    edit_workspace_free(&ws);
+    TEST_ASSERT_NULL(ws.rows);
+}
+
+// bit-parallel version tests
+static void edit_distance_bitpar_matches_dyn_random() {
+    unsigned seed = 2;
+    char a[301], b[301];
+
+    for (size_t t = 0; t < 2000; t++) {
+        // short, one-block and multi-block patterns
+        size_t max = t < 1000 ? 20 : t < 1500 ? 70 : 300;
+
+        random_word(a, rand_r(&seed) % max, 2 + t % 4, &seed);
+        random_word(b, rand_r(&seed) % max, 2 + t % 4, &seed);
+
+        TEST_ASSERT_EQUAL_INT(edit_distance_dyn(a, b), edit_distance_bitpar(a, b));
+    }
+}
+
+static void edit_distance_bitpar_matches_dyn_words() {
+    const char *words[] = {
+        "casa", "cassa", "cara", "vinaio", "vino", "tassa", "passato", "pioppo", "",
+        "precipitevolissimevolmente", "perche", "perché", "nel", "mezzo", "cammin",
+        "di", "nostra", "vita", "mi", "ritrovai", "per", "una", "selva", "oscura"
+    };
+    size_t count = sizeof(words) / sizeof(words[0]);
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < count; j++)
+            TEST_ASSERT_EQUAL_INT(edit_distance_dyn(words[i], words[j]), edit_distance_bitpar(words[i], words[j]));
+    }
+}
+
+static void edit_distance_bitpar_block_boundaries() {
+    char a[130], b[130];
+
+    // 64 and 128 characters fill their blocks exactly
+    for (size_t len = 63; len <= 129; len++) {
+        memset(a, 'a', len);
+        a[len] = '\0';
+        memcpy(b, a, len + 1);
+        b[len / 2] = 'b';
+
+        TEST_ASSERT_EQUAL_INT(0, edit_distance_bitpar(a, a));
+        TEST_ASSERT_EQUAL_INT(2, edit_distance_bitpar(a, b));
+        TEST_ASSERT_EQUAL_INT(1, edit_distance_bitpar(a, a + 1));
+    }
+}
+
+// bounded version tests
+static void edit_distance_bounded_matches_dyn_within_bound() {
+    unsigned seed = 3;
+    char a[64], b[64];
+
+    for (size_t t = 0; t < 3000; t++) {
+        random_word(a, rand_r(&seed) % 40, 2 + t % 3, &seed);
+        random_word(b, rand_r(&seed) % 40, 2 + t % 3, &seed);
+
+        int distance = edit_distance_dyn(a, b);
+        int k = rand_r(&seed) % 12;
+
+        TEST_ASSERT_EQUAL_INT(distance <= k ? distance : k + 1, edit_distance_bounded(a, b, k));
+    }
+}
+
+static void edit_distance_bounded_cutoffs() {
+    // rejected by the length difference, by the band and by a row minimum
+    TEST_ASSERT_EQUAL_INT(3, edit_distance_bounded("pioppo", "pi", 2));
+    TEST_ASSERT_EQUAL_INT(2, edit_distance_bounded("abcdef", "ghijkl", 1));
+    TEST_ASSERT_EQUAL_INT(1, edit_distance_bounded("casa", "cara", 0));
+
+    TEST_ASSERT_EQUAL_INT(0, edit_distance_bounded("pioppo", "pioppo", 0));
+    TEST_ASSERT_EQUAL_INT(4, edit_distance_bounded("tassa", "passato", 4));
+    TEST_ASSERT_EQUAL_INT(7, edit_distance_bounded("", "example", INT_MAX));
+}
+
+// signature filter tests
+static void signature_filter_never_rejects_within_bound() {
+    unsigned seed = 10;
+    char a[24], b[24];
+    WordSignature sa, sb;
+    size_t rejected[SIGNATURE_STAGES] = {0};
+
+    for (size_t t = 0; t < 2000; t++) {
+        random_word(a, rand_r(&seed) % 20, 6, &seed);
+        random_word(b, rand_r(&seed) % 20, 6, &seed);
+        signature_compute(a, &sa);
+        signature_compute(b, &sb);
+
+        // the bounds are lower bounds: a pair is never rejected at its own distance or above
+        int distance = edit_distance_dyn(a, b);
+        TEST_ASSERT_EQUAL_INT(1, signature_filter(&sa, &sb, distance, rejected));
+        TEST_ASSERT_EQUAL_INT(1, signature_filter(&sa, &sb, distance + 1, rejected));
+    }
+}
+
+static void signature_filter_stages() {
+    WordSignature casa, vino, cass, long_word;
+    size_t rejected[SIGNATURE_STAGES] = {0};
+
+    signature_compute("casa", &casa);
+    signature_compute("vino", &vino);
+    signature_compute("cass", &cass);
+    signature_compute("casamatta", &long_word);
+
+    TEST_ASSERT_EQUAL_INT(4, casa.length);
+    TEST_ASSERT_EQUAL_INT((1 << 0) | (1 << 2) | (1 << 18), casa.mask);
+
+    // five letters apart: too long
+    TEST_ASSERT_EQUAL_INT(0, signature_filter(&casa, &long_word, 4, rejected));
+    // no letter in common: seven letters held by one word only
+    TEST_ASSERT_EQUAL_INT(0, signature_filter(&casa, &vino, 3, rejected));
+    // same length and letters, but one a less and one s more
+    TEST_ASSERT_EQUAL_INT(0, signature_filter(&casa, &cass, 1, rejected));
+    TEST_ASSERT_EQUAL_INT(1, signature_filter(&casa, &cass, 2, rejected));
+
+    TEST_ASSERT_EQUAL_INT(1, rejected[SIGNATURE_LENGTH]);
+    TEST_ASSERT_EQUAL_INT(1, rejected[SIGNATURE_MASK]);
+    TEST_ASSERT_EQUAL_INT(1, rejected[SIGNATURE_COUNTS]);
+}
+
+// dictionary index tests
+static char *index_dictionary[] = {
+    "a", "casa", "cassa", "cara", "caro", "case", "vino", "vinaio", "tassa", "passato",
+    "pioppo", "perche", "per", "mezzo", "cammin", "vita", "selva", "oscura", "ca", "asa"
+};
+#define INDEX_DICTIONARY_WORDS (sizeof(index_dictionary) / sizeof(index_dictionary[0]))
+
+// fills corrections by comparing the word with every dictionary entry, like the original scan
+static void brute_force_corrections(const char *word, Corrections *corrections) {
+    corrections_clear(corrections);
+    for (size_t j = 0; j < INDEX_DICTIONARY_WORDS; j++)
+        corrections_offer(corrections, (uint32_t)j, edit_distance_dyn(word, index_dictionary[j]));
+    corrections_finish(corrections);
+}
+
+static void assert_same_corrections(const Corrections *expected, const Corrections *actual) {
+    TEST_ASSERT_EQUAL_INT(expected->distance, actual->distance);
+    TEST_ASSERT_EQUAL_INT(expected->count, actual->count);
+    for (size_t i = 0; i < expected->count; i++)
+        TEST_ASSERT_EQUAL_INT(expected->ids[i], actual->ids[i]);
+}
+
+static void compute_index_signatures(WordSignature *signatures) {
+    for (size_t i = 0; i < INDEX_DICTIONARY_WORDS; i++)
+        signature_compute(index_dictionary[i], &signatures[i]);
+}
+
+typedef void (*SearchFunction)(const void *index, const char *word, Corrections *corrections);
+
+static void search_length_index(const void *index, const char *word, Corrections *corrections) {
+    length_index_search(index, word, corrections);
+}
+
+static void search_bk_tree(const void *index, const char *word, Corrections *corrections) {
+    bk_tree_search(index, word, corrections);
+}
+
+static void search_trie(const void *index, const char *word, Corrections *corrections) {
+    trie_search(index, word, corrections);
+}
+
+static void search_deletion_index(const void *index, const char *word, Corrections *corrections) {
+    deletion_index_search(index, word, corrections);
+}
+
+static void search_qgram_index(const void *index, const char *word, Corrections *corrections) {
+    qgram_index_search(index, word, corrections);
+}
+
+// compares the search with the scan on every dictionary word, then on random words up to trials queries,
+// and returns how many pairs the signature filter rejected along the way
+static size_t assert_search_matches_scan(SearchFunction search, const void *index, unsigned seed, size_t trials) {
+    Corrections expected = {0}, actual = {0};
+    size_t rejected = 0;
+    char word[16];
+
+    for (size_t t = 0; t < trials; t++) {
+        if (t < INDEX_DICTIONARY_WORDS)
+            strcpy(word, index_dictionary[t]);
+        else
+            random_word(word, rand_r(&seed) % 10, 5, &seed);
+
+        brute_force_corrections(word, &expected);
+        search(index, word, &actual);
+        assert_same_corrections(&expected, &actual);
+
+        for (size_t s = 0; s < SIGNATURE_STAGES; s++)
+            rejected += actual.rejected[s];
+    }
+
+    corrections_free(&expected);
+    corrections_free(&actual);
+    return rejected;
+}
+
+static void length_index_search_matches_scan() {
+    LengthIndex *index = length_index_build(index_dictionary, NULL, INDEX_DICTIONARY_WORDS);
+
+    assert_search_matches_scan(search_length_index, index, 4, 300);
+
+    length_index_free(index);
+}
+
+static void length_index_search_with_signatures() {
+    WordSignature signatures[INDEX_DICTIONARY_WORDS];
+    compute_index_signatures(signatures);
+
+    LengthIndex *index = length_index_build(index_dictionary, signatures, INDEX_DICTIONARY_WORDS);
+
+    TEST_ASSERT_TRUE(assert_search_matches_scan(search_length_index, index, 11, 300) > 0);
+
+    length_index_free(index);
+}
+
+static void length_index_search_stops_at_length_gap() {
+    LengthIndex *index = length_index_build(index_dictionary, NULL, INDEX_DICTIONARY_WORDS);
+    Corrections corrections = {0};
+
+    // once "casa" is found at distance 1, only the buckets of length 2 to 4 are scanned
+    length_index_search(index, "cas", &corrections);
+    TEST_ASSERT_EQUAL_INT(1, corrections.distance);
+    TEST_ASSERT_EQUAL_INT(3, corrections.count);
+    TEST_ASSERT_EQUAL_STRING("casa", index_dictionary[corrections.ids[0]]);
+    TEST_ASSERT_EQUAL_STRING("case", index_dictionary[corrections.ids[1]]);
+    TEST_ASSERT_EQUAL_STRING("ca", index_dictionary[corrections.ids[2]]);
+    TEST_ASSERT_TRUE(corrections.examined < INDEX_DICTIONARY_WORDS);
+
+    corrections_free(&corrections);
+    length_index_free(index);
+}
+
+// BK-tree tests
+static void bk_tree_search_matches_scan() {
+    BkTree *tree = bk_tree_build(index_dictionary, INDEX_DICTIONARY_WORDS);
+
+    assert_search_matches_scan(search_bk_tree, tree, 5, 300);
+
+    bk_tree_free(tree);
+}
+
+static void mark_within(uint32_t id, int distance, void *arg) {
+    int *found = arg;
+
+    TEST_ASSERT_EQUAL_INT(0, found[id]);
+    found[id] = distance + 1;
+}
+
+static void bk_tree_within_matches_scan() {
+    BkTree *tree = bk_tree_build(index_dictionary, INDEX_DICTIONARY_WORDS);
+    int found[INDEX_DICTIONARY_WORDS];
+    unsigned seed = 6;
+    char word[16];
+
+    for (int k = 0; k <= 4; k++) {
+        for (size_t t = 0; t < 60; t++) {
+            random_word(word, rand_r(&seed) % 8, 5, &seed);
+            memset(found, 0, sizeof(found));
+
+            bk_tree_within(tree, word, k, mark_within, found);
+
+            // each word is reported once, with its distance, exactly when it is within k
+            for (size_t j = 0; j < INDEX_DICTIONARY_WORDS; j++) {
+                int distance = edit_distance_dyn(word, index_dictionary[j]);
+                TEST_ASSERT_EQUAL_INT(distance <= k ? distance + 1 : 0, found[j]);
+            }
+        }
+    }
+
+    bk_tree_free(tree);
+}
+
+static void bk_tree_search_keeps_duplicates() {
+    char *dictionary[] = { "casa", "cosa", "casa", "caso", "cosa" };
+    BkTree *tree = bk_tree_build(dictionary, 5);
+    Corrections corrections = {0};
+
+    bk_tree_search(tree, "cosa", &corrections);
+    TEST_ASSERT_EQUAL_INT(0, corrections.distance);
+    TEST_ASSERT_EQUAL_INT(2, corrections.count);
+    TEST_ASSERT_EQUAL_INT(1, corrections.ids[0]);
+    TEST_ASSERT_EQUAL_INT(4, corrections.ids[1]);
+
+    bk_tree_search(tree, "cas", &corrections);
+    TEST_ASSERT_EQUAL_INT(1, corrections.distance);
+    TEST_ASSERT_EQUAL_INT(3, corrections.count);
+    TEST_ASSERT_EQUAL_INT(0, corrections.ids[0]);
+    TEST_ASSERT_EQUAL_INT(2, corrections.ids[1]);
+    TEST_ASSERT_EQUAL_INT(3, corrections.ids[2]);
+
+    corrections_free(&corrections);
+    bk_tree_free(tree);
+}
+
+// trie tests
+static void trie_search_matches_scan() {
+    Trie *trie = trie_build(index_dictionary, INDEX_DICTIONARY_WORDS);
+
+    assert_search_matches_scan(search_trie, trie, 7, 300);
+
+    trie_free(trie);
+}
+
+static void trie_search_prefixes_and_duplicates() {
+    char *dictionary[] = { "cas", "", "casa", "cas", "casale", "ca" };
+    Trie *trie = trie_build(dictionary, 6);
+    Corrections corrections = {0};
+
+    // the words ending inside the path of another word are found, repeated ones too
+    trie_search(trie, "cas", &corrections);
+    TEST_ASSERT_EQUAL_INT(0, corrections.distance);
+    TEST_ASSERT_EQUAL_INT(2, corrections.count);
+    TEST_ASSERT_EQUAL_INT(0, corrections.ids[0]);
+    TEST_ASSERT_EQUAL_INT(3, corrections.ids[1]);
+
+    trie_search(trie, "x", &corrections);
+    TEST_ASSERT_EQUAL_INT(1, corrections.distance);
+    TEST_ASSERT_EQUAL_INT(1, corrections.count);
+    TEST_ASSERT_EQUAL_INT(1, corrections.ids[0]);
+
+    trie_search(trie, "casal", &corrections);
+    TEST_ASSERT_EQUAL_INT(1, corrections.distance);
+    TEST_ASSERT_EQUAL_INT(2, corrections.count);
+    TEST_ASSERT_EQUAL_INT(2, corrections.ids[0]);
+    TEST_ASSERT_EQUAL_INT(4, corrections.ids[1]);
+
+    corrections_free(&corrections);
+    trie_free(trie);
+}
+
+// deletion index tests
+static void deletion_index_search_matches_scan() {
+    // depth 0 always falls back to the scan but for exact matches, depth 3 rarely does
+    for (int depth = 0; depth <= 3; depth++) {
+        DeletionIndex *index = deletion_index_build(index_dictionary, NULL, INDEX_DICTIONARY_WORDS, depth);
+
+        assert_search_matches_scan(search_deletion_index, index, 8, 200);
+
+        deletion_index_free(index);
+    }
+}
+
+static void deletion_index_search_with_signatures() {
+    WordSignature signatures[INDEX_DICTIONARY_WORDS];
+    compute_index_signatures(signatures);
+
+    // depth 1 falls back to the scan often, so the filter runs on both paths
+    for (int depth = 1; depth <= 2; depth++) {
+        DeletionIndex *index = deletion_index_build(index_dictionary, signatures, INDEX_DICTIONARY_WORDS, depth);
+
+        TEST_ASSERT_TRUE(assert_search_matches_scan(search_deletion_index, index, 14, 200) > 0);
+
+        deletion_index_free(index);
+    }
+}
+
+static void deletion_index_search_falls_back_to_scan() {
+    DeletionIndex *index = deletion_index_build(index_dictionary, NULL, INDEX_DICTIONARY_WORDS, 2);
+    Corrections corrections = {0};
+
+    // "cassa" is found among the words sharing one of its variants
+    deletion_index_search(index, "cassa", &corrections);
+    TEST_ASSERT_EQUAL_INT(0, corrections.distance);
+    TEST_ASSERT_EQUAL_INT(1, corrections.count);
+    TEST_ASSERT_EQUAL_STRING("cassa", index_dictionary[corrections.ids[0]]);
+    TEST_ASSERT_TRUE(corrections.examined < INDEX_DICTIONARY_WORDS);
+
+    // nothing shares a variant with "zzzzzz": every word is verified by the scan
+    deletion_index_search(index, "zzzzzz", &corrections);
+    TEST_ASSERT_EQUAL_INT(7, corrections.distance);
+    TEST_ASSERT_EQUAL_INT(2, corrections.count);
+    TEST_ASSERT_EQUAL_STRING("a", index_dictionary[corrections.ids[0]]);
+    TEST_ASSERT_EQUAL_STRING("mezzo", index_dictionary[corrections.ids[1]]);
+    TEST_ASSERT_EQUAL_INT(INDEX_DICTIONARY_WORDS, corrections.examined);
+
+    corrections_free(&corrections);
+    deletion_index_free(index);
+}
+
+// q-gram index tests
+static void qgram_index_search_matches_scan() {
+    for (int q = 2; q <= 3; q++) {
+        QgramIndex *index = qgram_index_build(index_dictionary, NULL, INDEX_DICTIONARY_WORDS, q);
+
+        assert_search_matches_scan(search_qgram_index, index, 9, 300);
+
+        qgram_index_free(index);
+    }
+}
+
+static void qgram_index_search_with_signatures() {
+    WordSignature signatures[INDEX_DICTIONARY_WORDS];
+    compute_index_signatures(signatures);
+
+    for (int q = 2; q <= 3; q++) {
+        QgramIndex *index = qgram_index_build(index_dictionary, signatures, INDEX_DICTIONARY_WORDS, q);
+
+        TEST_ASSERT_TRUE(assert_search_matches_scan(search_qgram_index, index, 15, 300) > 0);
+
+        qgram_index_free(index);
+    }
+}
+
+static void qgram_index_postings_round_trip() {
+    char *dictionary[] = { "aaa", "ba", "aaa", "b" };
+    QgramIndex *index = qgram_index_build(dictionary, NULL, 4, 2);
+
+    // "aa" occurs twice in each "aaa": the list holds 0, 0, 2, 2 as deltas 0, 0, 2, 0
+    size_t slot = find_slot(index, 'a' << 9 | 'a');
+    const uint8_t *in = index->postings + index->begin[slot];
+    uint32_t expected[] = { 0, 0, 2, 0 };
+
+    TEST_ASSERT_EQUAL_INT(4, index->end[slot] - index->begin[slot]);
+    for (size_t i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(expected[i], get_varint(&in));
+
+    uint8_t buffer[5];
+    const uint8_t *big = buffer;
+    TEST_ASSERT_EQUAL_INT(5, put_varint(buffer, UINT32_MAX - 1));
+    TEST_ASSERT_EQUAL_INT(UINT32_MAX - 1, get_varint(&big));
+
+    qgram_index_free(index);
+}
+
+// indel automaton tests
+static void automaton_distance_matches_dyn() {
+    unsigned seed = 12;
+    char word[16], s[16];
+
+    for (int k = 0; k <= AUTOMATON_MAX_DISTANCE; k++) {
+        for (size_t t = 0; t < 50; t++) {
+            random_word(word, rand_r(&seed) % 12, 4, &seed);
+            IndelAutomaton *automaton = automaton_build(word, k);
+
+            for (size_t u = 0; u < 40; u++) {
+                random_word(s, rand_r(&seed) % 14, 4, &seed);
+
+                int distance = edit_distance_dyn(word, s);
+                TEST_ASSERT_EQUAL_INT(distance <= k ? distance : k + 1, automaton_distance(automaton, s));
+            }
+            TEST_ASSERT_EQUAL_INT(0, automaton_distance(automaton, word));
+
+            automaton_free(automaton);
+        }
+    }
+}
+
+static void automaton_search_matches_scan() {
+    Trie *trie = trie_build(index_dictionary, INDEX_DICTIONARY_WORDS);
+    Corrections expected = {0}, actual = {0};
+    unsigned seed = 13;
+    char word[16];
+
+    for (int k = 0; k <= AUTOMATON_MAX_DISTANCE; k++) {
+        for (size_t t = 0; t < 200; t++) {
+            if (t < INDEX_DICTIONARY_WORDS)
+                strcpy(word, index_dictionary[t]);
+            else
+                random_word(word, rand_r(&seed) % 10, 5, &seed);
+
+            brute_force_corrections(word, &expected);
+            automaton_search(trie, word, k, &actual);
+
+            // the same corrections when they are within k, none otherwise
+            if (expected.distance <= k) {
+                assert_same_corrections(&expected, &actual);
+            } else {
+                TEST_ASSERT_EQUAL_INT(0, actual.count);
+                TEST_ASSERT_EQUAL_INT(INT_MAX, actual.distance);
+            }
+        }
+    }
+
+    corrections_free(&expected);
+    corrections_free(&actual);
+    trie_free(trie);
+}
+
 int main(int argc, char const *argv[]) {
 
     UNITY_BEGIN();
@@ -136,6 +659,41 @@ int main(int argc, char const *argv[]) {
     RUN_TEST(edit_distance_dyn_zero);
     RUN_TEST(edit_distance_dyn_s1);
     RUN_TEST(edit_distance_dyn_s2);
+
+    RUN_TEST(edit_distance_dyn_ws_matches_recursive);
+    RUN_TEST(edit_distance_dyn_ws_grows_workspace);
+
+    RUN_TEST(edit_distance_bitpar_matches_dyn_random);
+    RUN_TEST(edit_distance_bitpar_matches_dyn_words);
+    RUN_TEST(edit_distance_bitpar_block_boundaries);
+
+    RUN_TEST(edit_distance_bounded_matches_dyn_within_bound);
+    RUN_TEST(edit_distance_bounded_cutoffs);
+
+    RUN_TEST(signature_filter_never_rejects_within_bound);
+    RUN_TEST(signature_filter_stages);
+
+    RUN_TEST(length_index_search_matches_scan);
+    RUN_TEST(length_index_search_with_signatures);
+    RUN_TEST(length_index_search_stops_at_length_gap);
+
+    RUN_TEST(bk_tree_search_matches_scan);
+    RUN_TEST(bk_tree_within_matches_scan);
+    RUN_TEST(bk_tree_search_keeps_duplicates);
+
+    RUN_TEST(trie_search_matches_scan);
+    RUN_TEST(trie_search_prefixes_and_duplicates);
+
+    RUN_TEST(deletion_index_search_matches_scan);
+    RUN_TEST(deletion_index_search_with_signatures);
+    RUN_TEST(deletion_index_search_falls_back_to_scan);
+
+    RUN_TEST(qgram_index_search_matches_scan);
+    RUN_TEST(qgram_index_search_with_signatures);
+    RUN_TEST(qgram_index_postings_round_trip);
+
+    RUN_TEST(automaton_distance_matches_dyn);
+    RUN_TEST(automaton_search_matches_scan);
     
     return UNITY_END();
 }
\ No newline at end of file